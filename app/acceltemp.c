@@ -152,6 +152,7 @@ void updateAccelerometer( void )
 	memcpy( &Accelerometers[0], accelData, 3 );
 	Accelerometers[3]++;
 	ENABLE_INTERRUPTS();
+	PDOMarkDirtyRange( &ObjDict_Data, Accelerometers, sizeof(Accelerometers) );
         
        
         
@@ -198,6 +199,7 @@ void updateAccelerometer( void )
           AccelerometersFiltered[1] = (UINT8)(y + 128);
           AccelerometersFiltered[2] = (UINT8)(z + 128);
           AccelerometersFiltered[3] = Accelerometers[3];
+          PDOMarkDirtyRange( &ObjDict_Data, AccelerometersFiltered, sizeof(AccelerometersFiltered) );
           
 
           
@@ -249,6 +251,7 @@ void updateAccelerometer( void )
               AccelerometersTilt[2] =   (INT8) atanT( ((UINT16)intsqrt(xxyy)<<8)   /    (UINT8)( z) );
             
             AccelerometersTilt[3] = Accelerometers[3];
+            PDOMarkDirtyRange( &ObjDict_Data, AccelerometersTilt, sizeof(AccelerometersTilt) );
           }
           
           
@@ -305,7 +308,11 @@ void runTemperatureTask( void )
 		degrC = MIN_TEMPR;
 	}
 	
-	Temperature = (UINT16)degrC;
+	if( Temperature != (UINT16)degrC )
+	{
+		Temperature = (UINT16)degrC;
+		PDOMarkDirty( &ObjDict_Data, &Temperature );
+	}
 	
         PORTA &=~ BIT7; //^^test
 
@@ -340,6 +347,7 @@ void updateDiagnostics( void )
         static UINT32 tDelayRef = 0; //JML: set to 0, so timesout first time through
         static UINT8 ch = 0;
         UINT8 res;
+        UNS8 *pDiag = NULL;
 	
         if(DiagnosticsEnabled)
         {
@@ -364,20 +372,25 @@ void updateDiagnostics( void )
           //set ch for next measurement  
           switch(ch)
           {
-            case 0: Diagnostic_VIC = res;
+            case 0: pDiag = &Diagnostic_VIC;
                     ch=1; 
                     break;
-            case 1: Diagnostic_VIN = res;
+            case 1: pDiag = &Diagnostic_VIN;
                     ch=3; //skip VOS, not currently configured
                     break;
-            case 2: Diagnostic_VOS = res;
+            case 2: pDiag = &Diagnostic_VOS;
                     ch=3; 
                     break;
-            case 3: Diagnostic_3V3 = res;
+            case 3: pDiag = &Diagnostic_3V3;
                     ch=0; 
                     break;
             default: ch=0;
           }	
+          if( pDiag && *pDiag != res )
+          {
+            *pDiag = res;
+            PDOMarkDirty( &ObjDict_Data, pDiag );
+          }
         }
         ADCSRA &=~ B(ADEN); //disable ADC to save power
 }
@@ -23,8 +23,7 @@ Project description:
 #include "objdict.h"
 #include "scheduler.h"
 #include "acceltemp.h"
-
-#define CO_ENABLE_LSS
+#include "can_AVR.h"
 
 /******************************DATA*****************************************/
 UNS16 volatile Delay = 20000;
@@ -32,6 +31,7 @@ UNS16 blink = 0;
 UNS8  tempNodeID = 2;
 UNS8 lastRequestedAddress = 0;
 UNS8 commandByte = 0;
+static TIMEVAL bootStamp = 0;
 /***************************************************************************/
 
 /******************************PROTOTYPES***********************************/
@@ -49,6 +49,8 @@ UNS8 WriteEEProm ( void );
 void main( void )
 {      
         sys_init();
+        initTimer();     // timer for CAN Festival interrupts and alarms, also times the boot stages
+        RecordBootTime( NULL );
         
 	if (CheckRestoreFlag()) 
         {
@@ -61,14 +63,16 @@ void main( void )
           //Then, overwrite EEPROM with these default settings
           SaveValues();
         }
+        UpdateContentHashes(); // pattern slot and restore image hashes (0x2024), hashed from the main loop
+        RecordBootTime( &BootTime_Restore );
         
         initStimTask();
         InitScheduler();  
         initAccelerometer();
-	initTimer();     // timer for CAN Festival interrupts and alarms
-	InitCANServerTask(); // also sets up CAN network -- 
+	InitCANServerTask(); // also sets up CAN network and starts the stagger into Waiting -- 
         //needs to run after RestoreValues
         initDiagnostics();
+        RecordBootTime( &BootTime_Init );
         
 	while (TRUE)
 	{
@@ -82,7 +86,11 @@ void main( void )
                 
 		RunCANServerTask();
                 
-                Status_TestValue++;           
+                RunChecksumTask(); // one slice of the OD triggered CRC-32 job (0x2023)
+                
+                RunContentHashTask(); // one slice of the content hashes (0x2024)
+                
+                Status_TestValue++; // free running, not marked dirty: it would send every pass
               
 
                   
@@ -102,9 +110,7 @@ void main( void )
                 }
                 
                 //PORTE |= BIT0;  //DEBUG indicate sleep
-                SMCR |= BIT0; //Set Sleep Enable in Idle Mode
-                asm("SLEEP");
-                SMCR &=~BIT0; //Disable sleep
+                LowPowerIdle(); //sleep until the next interrupt
                 //PORTE &=~ BIT0;  //DEBUG indicate wakeup
 
 		
@@ -151,12 +157,119 @@ void resetTimeOut( UINT32 *tRef )
 	*tRef = getSystemTime();
 }
 
+//==================================
+//    LOW POWER
+//==================================
+
+/**
+ * @brief Sleeps until the next interrupt.  Once the node has sat in Waiting or Stopped
+ * for LOW_POWER_ENTRY_MS, the 1ms tick is stretched and the analog comparator is gated 
+ * so the CPU only wakes on CAN traffic, a CANopen alarm (tmr3) or the slow tick.
+ * @details Idle is the deepest sleep mode that keeps clkIO running, which the CAN 
+ * controller needs to receive frames.  Power-save and power-down would stop the CAN 
+ * controller and drop SYNCs, so the savings come from waking less often instead. 
+ * A SYNC restores the 1ms tick from within the CAN interrupt (see SyncScheduler).
+ */
+void LowPowerIdle( void )
+{
+  static UINT32 lowPowerRef = 0;
+  UNS8 state = getState( &ObjDict_Data );
+  UNS8 managed = 0;
+  UNS32 latency;
+  
+  if ( !LowPower_Enable || (state != Waiting && state != Stopped) )
+    resetTimeOut( &lowPowerRef );
+  else if ( isTimedOut( &lowPowerRef, LOW_POWER_ENTRY_MS ) ) //lets the discharge switch and VOS settle first
+    managed = 1;
+  
+  DISABLE_INTERRUPTS();
+  if ( msg_received || TimerPending() ) //frame or alarm arrived after RunCANServerTask, don't sleep on it
+  {
+    ENABLE_INTERRUPTS();
+    return;
+  }
+  
+  if ( managed )
+  {
+    ACSR |= B(ACD); //turn off analog comparator
+    SetSchedulerTick( 1 );
+  }
+  
+  SMCR |= BIT0; //Set Sleep Enable in Idle Mode
+  ENABLE_INTERRUPTS(); //the instruction following sei is always executed, so no wakeup can be missed
+  asm("SLEEP");
+  SMCR &=~BIT0; //Disable sleep
+  
+  if ( managed )
+  {
+    SetSchedulerTick( 0 );
+    ACSR &=~ B(ACD);
+    LowPower_SleepCount++;
+    
+    if ( msg_received ) //woken by CAN
+    {
+      latency = TIMEVAL_TO_US( (UNS16)((UNS16)TCNT3 - canRxTimeStamp) ); // tmr3 tick is 8 to 32us with FOSC
+      LowPower_WakeLatency = latency;
+      if ( latency > LowPower_MaxWakeLatency )
+        LowPower_MaxWakeLatency = latency;
+    }
+  }
+}
+
+/**
+ * @brief Sleep requested by NMT_Enter_Low_Power.  Shuts down the peripherals and the 
+ * 1ms tick, then idles until a new CAN frame is received.  The frame is left for the
+ * stack to process once the peripherals are back up, as are frames already queued behind
+ * the NMT command.
+ * @details sysTimer does not advance while asleep.  CANopen alarms (heartbeat) still
+ * wake the CPU; their deferred callbacks run before it goes back to sleep.
+ */
+void EnterDeepSleep( void )
+{
+  UNS8 adcsra = ADCSRA;
+  UNS8 twcr = TWCR;
+  UNS8 queued = msg_received;
+  
+  ADCSRA &= ~BIT7; //turn off ADC
+  sleepAccelerometer();
+  TWCR &= ~BIT2; //turn off I2C
+  PORTG &= ~BIT2; //turn off Heartbeat LED
+  ACSR |= B(ACD); //turn off analog comparator
+  TIMSK0 &= ~B(OCIE0A); //stop the 1ms tick
+  
+  while ( TRUE )
+  {
+    TimerDispatchPending();
+    DISABLE_INTERRUPTS();
+    if ( msg_received != queued )
+      break;
+    if ( TimerPending() ) //alarm expired while dispatching
+    {
+      ENABLE_INTERRUPTS();
+      continue;
+    }
+    SMCR |= BIT0; //Set Sleep Enable in Idle Mode
+    ENABLE_INTERRUPTS();
+    asm("SLEEP");
+    SMCR &=~BIT0; //Disable sleep
+  }
+  ENABLE_INTERRUPTS();
+  
+  TIMSK0 |= B(OCIE0A); //restart the 1ms tick
+  ACSR &=~ B(ACD);
+  TWCR = twcr & ~BIT7; //I2C back as it was, without writing TWINT (which would clear it)
+  ADCSRA = adcsra & ~BIT4; //ADC back as it was, without clearing a pending ADIF
+  initAccelerometer();
+  LowPower_SleepCount++;
+}
+
 //==================================
 //    APP SPECIFIC CANFESTIVAL
 //==================================
 
 /**
- * @brief Lets application process SYNC message if necessary
+ * @brief Lets application process SYNC message if necessary.  X_Network is already set
+ *        from the SYNC by the CAN isr (SyncLatchCommand), only the OD copy is made here.
  * @param *m 8 byte message sent with SYNC objects from PM
  */
 void processSYNCMessageForApp(Message* m)
@@ -164,14 +277,7 @@ void processSYNCMessageForApp(Message* m)
     UNS8 i = 0;
     for (i = 0; i < m->len; i++)
       CommandValues[i] = m->data[i]; // used to guarantee an 8 byte array
-    
-    for (i = 0; i < 4; i++)
-    {
-      if(X_ChannelMap[i] > 0 && X_ChannelMap[i] <= m->len)
-        X_Network[i] = CommandValues[X_ChannelMap[i]-1]; //JML: X_ChannelMap 1-based 
-    }
-    
-
+    PDOMarkDirtyRange( &ObjDict_Data, CommandValues, m->len );
 }
 
 
@@ -332,7 +438,8 @@ void EnterRecordXFunc(CO_Data* d, Message *m)
 }
 
 /**
- * @brief Command processor to let CE read various memory locations
+ * @brief Command processor to let CE read various memory locations.  Superseded by the
+ *        memory window at 0x2022, streamed by SDO at once; kept for the tools still on 0x2020.
  * @param none
  */
 void ReadMemory(void)
@@ -350,6 +457,8 @@ void ReadMemory(void)
         else if (memorySelect != 0)
           statusByteMemory = 4;
       
+        if (memorySelect != 0)
+          PDOMarkDirty( &ObjDict_Data, &statusByteMemory );
         memorySelect = 0;
        
 }
@@ -462,13 +571,26 @@ UNS8 WriteEEProm ( void )
 //==================================
 
 /**
- * @brief Sets NodeId and S/N based on settings from bootloader.  Also has important role 
- * of delaying continuation based on node number
+ * @brief Records the time spent in a boot stage, since the previous call, in the OD (0x2014).
+ * Measured on the 32 bit alarm timebase and converted to us, so the unit is the same at any
+ * FOSC and stages of any length are measured right.
+ * @param stage OD variable for the stage that just ended, NULL to only restart the stamp
  */
-void initNodeIDSerialNumber( void )
+void RecordBootTime( UNS32 *stage )
 {
-    UINT32 delay = START_DELAY_MS*1000UL; //convert to clock cycles, still running at Bootloader clock speed (1MHz)
+  TIMEVAL now = TimerGetTime();
+  
+  if ( stage != NULL )
+    *stage = TIMEVAL_TO_US( now - bootStamp );
+  bootStamp = now;
+}
 
+/**
+ * @brief Sets NodeId and S/N based on settings from bootloader.  The startup stagger based 
+ * on node number is done later by InitCANServerTask, with the CAN controller running
+ */
+void initNodeIDSerialNumber( void )
+{
     tempNodeID = *(UINT8   __farflash  *)0x1DF00;
     if (tempNodeID <= 0x0F && tempNodeID > 0)
     {
@@ -479,14 +601,6 @@ void initNodeIDSerialNumber( void )
     
     ObjDict_obj1018_Serial_Number = *(UINT8 __farflash *)0x1FFFE + \
       ((UINT16)(*(UINT8 __farflash *)0x1FFFD) << 8);
-    
-    
-    //startup delay is START_DELAY_MS*(nodeID-1), 
-    delay = delay*(Status_NodeId-1)/13;
-    
-    //PORTE |= BIT1; //DEBUG ONLY set PE1 high
-    while( delay-- ); //this line takes 13 clock ticks per iteration if delay is uint32
-    //PORTE &=~ BIT1; //DEBUG ONLY set PE1 low
 }
 
 /**
@@ -564,7 +678,6 @@ void sys_init( void )
         //CAN will be reenabled by canInit routine after bittimings have been set for new clock speed
         
         initNodeIDSerialNumber(); //initialize serial number, node number
-                                  //delay based on node number before increasing clock
         
         CLKPR = B(CLKPCE); // enable scale clock, Interrupts must be off.
                            // Next step takes 4 clock cycles
@@ -13,7 +13,8 @@
 
 #define TIMEOUT_ms(n)	((n))		
 #define TIMEOUT_sec(n)	(TIMEOUT_ms((n) * 1000L))	
-#define START_DELAY_MS  4UL	//to be multiplied by nodeID on startup
+#define START_DELAY_MS  4UL	//to be multiplied by (nodeID-1) on startup, staggers entry into Waiting
+#define LOW_POWER_ENTRY_MS 300UL //time in Waiting/Stopped before the tick is stretched, must exceed DischargeTime
 
 // --------   DATA   ------------
 
@@ -25,6 +26,9 @@ UINT8 isTimedOut( UINT32 *tRef, UINT32 tAlarm );
 void resetTimeOut( UINT32 *tRef );
 void processSYNCMessageForApp(Message* m);
 UINT8 txRxSpi( UINT8 d );
+void LowPowerIdle( void );
+void EnterDeepSleep( void );
+void RecordBootTime( UNS32 *stage );
 
 void StartNodesFunc(CO_Data* d, Message *m);
 void StopNodesFunc(CO_Data* d, Message *m);
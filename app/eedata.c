@@ -32,11 +32,31 @@
 */
 // --------   DATA   ------------
 
+// write queue, drained in order by the EE_READY interrupt.  The bytes wait in a ring, described by
+// runs of consecutive addresses.  Each address is queued once, a later write of the same byte 
+// replaces the queued value
+static UNS8  eeQueueData[EEQUEUE_SIZE];
+static UNS8  eeQueueHead = 0;
+static UNS16 eeQueueCount = 0;
+static UNS16 eeRunAddress[EEQUEUE_RUNS];
+static UNS8  eeRunLength[EEQUEUE_RUNS];
+static UNS8  eeRunHead = 0;
+static UNS8  eeRunCount = 0;
 
+// erase (0xFF) still to be written, [eeEraseAddress, eeEraseEnd)
+static UNS16 eeEraseAddress = 0;
+static UNS16 eeEraseEnd = 0;
 
 
 // -------- PROTOTYPES ----------
 
+static void UpdateRestoreHash( void );
+static void UpdatePatternHashes( void );
+static UNS16 EEQueue_Find( UNS16 address, UNS16 *span );
+static void EEQueue_Put( UNS16 address, UNS8 data );
+static void EEQueue_Start( void );
+static void EEQueue_Service( void );
+static void EEQueue_Wait( void );
 
  
 //============================
@@ -64,6 +84,67 @@ UINT8 CheckRestoreFlag(void)
 
 
 
+/*
+ * @ingroup eeprom
+ * @brief Walks the restore image: the data bytes of every subindex of every index in RestoreList 
+ *        (0x2900), packed in list order starting at EEPROM address 2.  Indices and subindices themselves
+ *        are not stored, so SaveValues() and RestoreValues() share this walk to keep the layout identical.  
+ * @details The object tables are resolved once per index and the subindex variables are copied 
+ *          directly to/from EEPROM, without the readLocalDict/writeLocalDict round trip per subindex.
+ *          On restore, OD callbacks registered on a subindex are still called so a restore while 
+ *          in Waiting has the same side effects as an SDO write. 
+ * @param save 1 = OD to EEPROM, 0 = EEPROM to OD
+ * @param limit end of the image, a restore stops at the first subindex that does not fit in it
+ * @return address following the last byte of the image
+ */
+static UINT16 WalkRestoreImage( UINT8 save, UINT16 limit )
+{
+  const indextable *ptrTable;
+  ODCallback_t *Callback;
+  UINT32 errorCode;
+  UINT8 nSubIndices;
+  UINT16 size;
+  UINT16 counter = 2; //NOTE: counter starts at 2 (0 and 1 used to store size)
+  UINT8 i, k;
+  
+  for (i = 0; i < sizeof(RestoreList)/sizeof(RestoreList[0]); i++)
+  {
+    //don't let user save/restore below 0x1018 in OD, currently to make sure 1st subindex specifies nSubIndices
+    if (RestoreList[i] < 0x1018)  
+      continue; 
+    
+    ptrTable = scanIndexOD( &ObjDict_Data, RestoreList[i], &errorCode, &Callback );
+    if ( errorCode != OD_SUCCESSFUL )
+      break;
+    
+    if ( ptrTable->pSubindex[0].bDataType != uint8 ) // First subindex must be a UINT8 see objdictdef.h for datatypes
+      continue;
+    
+    nSubIndices = *(UINT8 *)ptrTable->pSubindex[0].pObject;
+    if ( nSubIndices >= ptrTable->bSubCount )
+      nSubIndices = ptrTable->bSubCount - 1;
+    
+    for (k = 1; k <= nSubIndices; k++)
+    {
+      size = ptrTable->pSubindex[k].size;
+      if ( counter + size >= limit )
+        return counter;
+      
+      if ( save )
+        EEPROM_write( counter, (UNS8 *)ptrTable->pSubindex[k].pObject, size );
+      else
+      {
+        EEPROM_read( counter, (UNS8 *)ptrTable->pSubindex[k].pObject, size );
+        if ( Callback && Callback[k] )
+          (*Callback[k])( &ObjDict_Data, ptrTable, k );
+      }
+      counter += size;
+    }
+  }
+  
+  return counter;
+}
+
 /*
  * @ingroup eeprom
  * @brief Saves the values of custom OD entries (specified in RestoreList OD index 0x2900) 
@@ -75,59 +156,21 @@ UINT8 CheckRestoreFlag(void)
  * @details Called from NMT_Do_Restore_Cmd (only when in the Waiting Mode) and from the startup sequence.
  *          The first two bytes in EEPROM specify the amount EEPROM used by this function.  All OD indices used by the
  *          RestoreList MUST have more than one subindex, where the first subindex specifies the number of subindices.
- *          Takes ~9ms per byte that needs to be saved.
+ *          Returns once the bytes that changed since the last save are queued; the EE_READY interrupt 
+ *          writes them, ~9ms each (EEQueue_Status 0x2025.3).
  */
 void SaveValues( void )
 {
-  UINT8 nSubIndices;
-  UNS32 size = 0;  
-  UNS8  type = 0;  
-  UINT8 data[MAX_BYTES_PER_SUBINDEX];
-  UINT32 abortCode = 0;
-  UINT16 counter = 2; //NOTE: counter starts at 2 (0 and 1 used to store size later)
-  UINT8 i = 0;
+  UINT8 data[2];
+  UINT16 counter;
+  
+  counter = WalkRestoreImage( 1, MAX_EEPROM_MEMORY );
   
-
-  //loop through each index in RestoreList
-  for (i = 0; i < sizeof(RestoreList); i++)
-  {
-    //don't let user save/restore below 0x1018 in OD, currently to make sure 1st subindex specifies nSubIndices
-    if (RestoreList[i] < 0x1018)  
-      continue; 
-    
-    //need to reset the size before the next "read" 
-    size = 0;  
-    type = 0;
-    //read the 0th subindex (nSubIndices) at the current index
-    abortCode = readLocalDict( &ObjDict_Data, RestoreList[i], 0, &nSubIndices, &size, &type, 0);  
-    if ( abortCode != OD_SUCCESSFUL )
-               break;
-
-    if (type == uint8) // First subindex must be a UINT8 see objdictdef.h for datatypes
-    {
-        //loop through each subindex and write bytes to EEPROM
-        for (int k = 1; k <= nSubIndices; k++) //the first element of subIndexSize must contain the number of subindices
-        {
-          size = 0;
-          //?what happens here if subindex has more bytes than MAX_BYTES_PER_SUBINDEX?
-          abortCode = readLocalDict( &ObjDict_Data, RestoreList[i], k, data, &size, &type, 0);
-          if ( abortCode != OD_SUCCESSFUL )
-                 break;
-          
-          //write all the subindex bytes to EEPROM
-          if (counter+size < MAX_EEPROM_MEMORY )
-          {
-            EEPROM_write(counter, data, size );
-            counter += size;
-          }
-          
-        }
-      }
-  }
   //write the number of bytes used (current counter value) in the first 2 bytes of EEPROM
   data[0] = (UINT8)counter;
   data[1] = (UINT8)(counter >> 8);
   EEPROM_write(0, data, 2); 
+  UpdateRestoreHash();
 
   //NOTE: disabling/enabling interrupts is handled in EEPROM_write routine!
 }
@@ -144,61 +187,20 @@ void SaveValues( void )
  *        OD subindices in the order specified by RestoreList; the indices and subindices themselves are not 
  *        stored in EEPROM.  
  * @details Called from NMT_Do_Restore_Cmd (only when in the Waiting Mode) and from the startup sequence.
- *          All OD indices used by the RestoreList MUST have more than one subindex, where the first subindex 
- *          specifies the number of subindices.  
+ *          Copies the image straight into the OD variables in a single pass.  Only the number of bytes 
+ *          recorded by SaveValues() is read; subindices past the end of the image keep their OD defaults.
 */
 void RestoreValues ( void )
 {
-
-  UINT8 nSubIndices;
-  UNS32 size = 0;  
-  UNS8  type = 0;  
-  UINT8 data[MAX_BYTES_PER_SUBINDEX];  
-  UINT32 abortCode = 0;;
-  UINT16 counter = 2;
+  UINT8 data[2];
+  UINT16 imageSize;
   
-
-    
-    for (int i = 0; i < sizeof(RestoreList); i++)
-    {
-      //don't let user save/restore below 0x1018 in OD, currently to make sure 1st subindex specifies nSubIndices
-      if (RestoreList[i] < 0x1018)  
-        continue; 
-    
-      size = 0;  
-      type = 0;
-
-      //read the 0th subindex (nSubIndices) at the current index
-      abortCode = readLocalDict( &ObjDict_Data, RestoreList[i], 0, &nSubIndices, &size, &type, 0);
-      if ( abortCode != OD_SUCCESSFUL )
-               break;
-
-      if ( type == uint8 ) 
-      {
-        //loop through each subindex and read bytes from EEPROM
-        for (int k = 1; k <=  nSubIndices; k++)
-        {
-          size = 0;
-          //read current values from OD to get length of subindex
-          abortCode = readLocalDict( &ObjDict_Data, RestoreList[i], k, data, &size, &type, 0);
-          if ( abortCode != OD_SUCCESSFUL )
-                 break;
-          
-          //read all subindex bytes from EEPROM
-          if( counter+size < MAX_EEPROM_MEMORY )
-          {
-              EEPROM_read( counter, data, size ); 
-              counter += size;
-          }
-          //write data to OD
-          abortCode = writeLocalDict( &ObjDict_Data, RestoreList[i], k, data, &size, 0);
-          if ( abortCode != OD_SUCCESSFUL )
-                 break;
-        }
-      }
-    }  
-
-
+  EEPROM_read(0, data, 2);
+  imageSize = data[0] + ((UINT16)data[1] << 8);
+  if ( imageSize > MAX_EEPROM_MEMORY )
+    imageSize = MAX_EEPROM_MEMORY;
+  
+  WalkRestoreImage( 0, imageSize + 1 );
 }
 
 
@@ -226,6 +228,7 @@ void ResetToODDefault(void)
  */
 void ResetModule(void)
 {
+  EEPROM_Flush();
   DISABLE_INTERRUPTS();
   // disable the wdt if it was enabled from the reset
   WDTCR = (1 << WDCE);  
@@ -274,24 +277,553 @@ UNS8 ReadLocalFlashData( UNS32 nvAddress, UNS8 * data, UNS8 numData )
 
 /**
  * @ingroup eeprom
- * @brief writes 0xFF to entire EEPROM (4KB). Takes 36s to complete! 
+ * @brief writes 0xFF to entire EEPROM (4KB).  Returns at once, the EE_READY interrupt erases in the
+ *        background (up to 36s, bytes already 0xFF are skipped).  Reads see the erased space right away.
  * @param space: 0=all EEPROM, 1=Restore space (0x000-0x3FF), 2=Pattern Space (0x400-0xFFF)
  */
 void EraseEprom(UNS8 space)
 {
-  UINT8 byteErase[EEPROM_ERASE_SIZE];
-  UINT16 i;
-  memset(byteErase, 0xFF, EEPROM_ERASE_SIZE);
+  UINT16 start = (space == 2) ? PATTERNS_EEPROM_ADDRESS : 0;
+  UINT16 end = (space == 1) ? PATTERNS_EEPROM_ADDRESS : MAX_EEPROM_MEMORY;
+  UINT16 address, index;
+  UNS8 r, n, k;
+  
+  DISABLE_INTERRUPTS();
+  if ( eeEraseAddress < eeEraseEnd && (start > eeEraseEnd || end < eeEraseAddress) )
+  {
+    while ( eeEraseAddress < eeEraseEnd ) //not contiguous with the erase still running: finish it first
+      EEQueue_Wait();
+  }
+  index = eeQueueHead; //queued bytes inside the space are erased over
+  for (n = 0, r = eeRunHead; n < eeRunCount; n++, r = (r + 1) & (EEQUEUE_RUNS - 1))
+  {
+    for (k = 0, address = eeRunAddress[r]; k < eeRunLength[r]; k++, address++, index++)
+    {
+      if ( address >= start && address < end )
+        eeQueueData[index & (EEQUEUE_SIZE - 1)] = 0xFF;
+    }
+  }
+  if ( eeEraseAddress >= eeEraseEnd )
+  {
+    eeEraseAddress = start;
+    eeEraseEnd = end;
+  }
+  else
+  {
+    if ( start < eeEraseAddress )
+      eeEraseAddress = start;
+    if ( end > eeEraseEnd )
+      eeEraseEnd = end;
+  }
+  EEQueue_Start();
+  ENABLE_INTERRUPTS();
   
+  //hashed from the erased view, only the spaces erased
+  if( space!=1 )
+    UpdatePatternHashes();
   if( space!=2 )
+    UpdateRestoreHash();
+}
+
+/**
+ * @ingroup eeprom
+ * @brief SDO stream of the pattern area (0x2021.1): reads the 48 patterns straight from EEPROM
+ */
+static UNS32 PatternArea_Read( CO_Data* d, const ODStream *stream, UNS32 offset, UNS8 *pData, UNS8 nbBytes )
+{
+  EEPROM_read( (UINT16)(PATTERNS_EEPROM_ADDRESS + offset), pData, nbBytes );
+  return 0;
+}
+
+/**
+ * @ingroup eeprom
+ * @brief SDO stream of the pattern area (0x2021.1): writes each segment straight to EEPROM.
+ *        Only in Waiting, as the other EEPROM writes.  The active patterns are reloaded
+ *        by UpdateActivePatterns() on the next mode change.
+ */
+static UNS32 PatternArea_Write( CO_Data* d, const ODStream *stream, UNS32 offset, const UNS8 *pData, UNS8 nbBytes )
+{
+  if ( d->nodeState != Waiting )
+    return SDOABT_DEVICE_STATE;
+  if ( nbBytes )
+    EEPROM_write( (UINT16)(PATTERNS_EEPROM_ADDRESS + offset), (UNS8 *)pData, nbBytes );
+  else
+    UpdateContentHashes();
+  return 0;
+}
+
+/**
+ * @ingroup eeprom
+ * @brief SDO stream of the application flash image (0x2021.2), read only
+ */
+static UNS32 FlashImage_Read( CO_Data* d, const ODStream *stream, UNS32 offset, UNS8 *pData, UNS8 nbBytes )
+{
+  UNS8 i;
+  
+  for (i = 0; i < nbBytes; i++)
+    pData[i] = *(UINT8 __farflash *)(offset + i); 
+  return 0;
+}
+
+const ODStream PatternArea_Stream = { MAX_PATTERNS*BYTES_PER_PATTERN, &PatternArea_Read, &PatternArea_Write };
+const ODStream FlashImage_Stream = { MAX_FLASH_MEMORY, &FlashImage_Read, NULL };
+
+/**
+ * @ingroup eeprom
+ * @brief SDO stream of the memory window (0x2022.4): MemWindow_Length bytes of flash or EEPROM
+ *        from MemWindow_Address
+ */
+static UNS32 MemWindow_Read( CO_Data* d, const ODStream *stream, UNS32 offset, UNS8 *pData, UNS8 nbBytes )
+{
+  if ( MemWindow_Select == 1 )
+    return FlashImage_Read( d, stream, MemWindow_Address + offset, pData, nbBytes );
+  EEPROM_read( (UINT16)(MemWindow_Address + offset), pData, nbBytes );
+  return 0;
+}
+
+/**
+ * @ingroup eeprom
+ * @brief SDO stream of the memory window: writes EEPROM only, in Waiting only
+ */
+static UNS32 MemWindow_Write( CO_Data* d, const ODStream *stream, UNS32 offset, const UNS8 *pData, UNS8 nbBytes )
+{
+  if ( MemWindow_Select != 4 )
+    return OD_WRITE_NOT_ALLOWED;
+  if ( d->nodeState != Waiting )
+    return SDOABT_DEVICE_STATE;
+  if ( nbBytes )
+    EEPROM_write( (UINT16)(MemWindow_Address + offset), (UNS8 *)pData, nbBytes );
+  else
+    UpdateContentHashes();
+  return 0;
+}
+
+ODStream MemWindow_Stream = { 0, &MemWindow_Read, &MemWindow_Write };
+
+/**
+ * @ingroup eeprom
+ * @brief OD callback of the memory window select, address and length (0x2022.1 to 3): 
+ *        sizes the window stream.  A length of 0 runs to the end of the memory.  The window
+ *        is left empty while the select or the address is out of range, so they can be 
+ *        written in any order.
+ */
+UNS32 MemWindow_Update( CO_Data* d, const indextable *unused_indextable, UNS8 unused_bSubindex )
+{
+  UNS32 memSize;
+  
+  MemWindow_Stream.size = 0;
+  if ( MemWindow_Select == 1 )
+    memSize = MAX_FLASH_MEMORY;
+  else if ( MemWindow_Select == 4 )
+    memSize = MAX_EEPROM_MEMORY;
+  else
+    memSize = 0;  // select not written yet (0) or unknown: empty window, as an out of range address
+  if ( MemWindow_Address >= memSize )
+    return OD_SUCCESSFUL;
+  
+  memSize -= MemWindow_Address;
+  if ( MemWindow_Length && MemWindow_Length < memSize )
+    memSize = MemWindow_Length;
+  MemWindow_Stream.size = memSize;
+  return OD_SUCCESSFUL;
+}
+
+/**
+ * @ingroup eeprom
+ * @brief CRC-8 (x^8 + x^2 + x + 1, initial value 0) of a pattern record
+ * @param crc CRC of the bytes before, 0 for the first ones
+ * @param *data the bytes
+ * @param length number of bytes
+ * @return the CRC updated with the bytes
+ */
+UNS8 PatternCRC( UNS8 crc, const UNS8 * data, UNS8 length )
+{
+  UNS8 i;
+  
+  while (length--)
+  {
+    crc ^= *data++;
+    for (i = 0; i < 8; i++)
+      crc = (crc & 0x80) ? (UNS8)((crc << 1) ^ 0x07) : (UNS8)(crc << 1);
+  }
+  return crc;
+}
+
+/**
+ * @ingroup eeprom
+ * @brief EEPROM address of the pattern slot of a stream of PatternSlot_Stream[]
+ */
+static UINT16 PatternSlot_Address( const ODStream *stream )
+{
+  return PATTERNS_EEPROM_ADDRESS + BYTES_PER_PATTERN*(UINT16)(stream - PatternSlot_Stream);
+}
+
+/**
+ * @ingroup eeprom
+ * @brief SDO stream of a pattern slot (0x3302.1 to 0x3302.48): reads the record, its CRC last
+ */
+static UNS32 PatternSlot_Read( CO_Data* d, const ODStream *stream, UNS32 offset, UNS8 *pData, UNS8 nbBytes )
+{
+  EEPROM_read( (UINT16)(PatternSlot_Address( stream ) + offset), pData, nbBytes );
+  return 0;
+}
+
+// channel byte of each pattern slot download, held back until the record passes its CRC
+static UNS8 patternSlotChannel[MAX_PATTERNS];
+
+/**
+ * @ingroup eeprom
+ * @brief SDO stream of a pattern slot: writes each segment straight to the slot, in Waiting only.
+ *        The channel byte is written as 0 with the first segment, so an aborted download leaves
+ *        an empty slot that UpdateActivePatterns() skips.  On commit the slot is read back from 
+ *        EEPROM and must hold the whole record with a matching CRC before its channel is written.
+ */
+static UNS32 PatternSlot_Write( CO_Data* d, const ODStream *stream, UNS32 offset, const UNS8 *pData, UNS8 nbBytes )
+{
+  UNS8 slot = (UNS8)(stream - PatternSlot_Stream);
+  UINT16 addr = PatternSlot_Address( stream );
+  UNS32 abortCode = 0;
+  UNS8 data[8];
+  UNS8 crc = 0;
+  UNS8 i;
+  
+  if ( d->nodeState != Waiting )
+    return SDOABT_DEVICE_STATE;
+  if ( nbBytes )
+  {
+    if ( offset == 0 )
+    {
+      patternSlotChannel[slot] = pData[0];
+      data[0] = 0;
+      EEPROM_write( addr, data, 1 );
+      pData++;
+      nbBytes--;
+      offset++;
+    }
+    EEPROM_write( (UINT16)(addr + offset), (UNS8 *)pData, nbBytes );
+    return 0;
+  }
+  
+  for (i = 0; i < BYTES_PER_PATTERN; i += sizeof(data))
+  {
+    EEPROM_read( addr + i, data, sizeof(data) );
+    if ( i == 0 )
+      data[0] = patternSlotChannel[slot];
+    crc = PatternCRC( crc, data, (i + sizeof(data) > PATTERN_CRC_OFFSET) ? PATTERN_CRC_OFFSET - i : sizeof(data) );
+  }
+  if ( offset != BYTES_PER_PATTERN )
+    abortCode = OD_LENGTH_DATA_INVALID;
+  else if ( crc != data[sizeof(data) - 1] )
+    abortCode = SDOABT_DATA_NOT_STORED;
+  else
+    EEPROM_write( addr, &patternSlotChannel[slot], 1 );
+  UpdatePatternHash( slot );
+  return abortCode;
+}
+
+#define PATTERN_SLOT_STREAM { BYTES_PER_PATTERN, &PatternSlot_Read, &PatternSlot_Write }
+#define PATTERN_SLOT_STREAMS_8 PATTERN_SLOT_STREAM, PATTERN_SLOT_STREAM, PATTERN_SLOT_STREAM, PATTERN_SLOT_STREAM,\
+                               PATTERN_SLOT_STREAM, PATTERN_SLOT_STREAM, PATTERN_SLOT_STREAM, PATTERN_SLOT_STREAM
+
+const ODStream PatternSlot_Stream[MAX_PATTERNS] = 
+{
+  PATTERN_SLOT_STREAMS_8, PATTERN_SLOT_STREAMS_8, PATTERN_SLOT_STREAMS_8,
+  PATTERN_SLOT_STREAMS_8, PATTERN_SLOT_STREAMS_8, PATTERN_SLOT_STREAMS_8
+};
+
+// content hashes, kept up to date by every EEPROM pattern and restore image write
+static UNS16 PatternHash[MAX_PATTERNS];
+
+// content hash job, run by RunContentHashTask()
+#define HASHJOB_PATTERNS        0x01
+#define HASHJOB_RESTORE         0x02
+static UNS8   hashRequest = 0;
+static UNS8   hashItem = MAX_PATTERNS;            // pattern slot, MAX_PATTERNS for the restore image
+static UINT16 hashAddress;
+static UINT16 hashRemaining = 0;
+static UNS16  hashCrc;
+
+/* CRC-16 CCITT (x^16 + x^12 + x^5 + 1, initial value 0), the one of the SDO block transfers, 
+   computed a nibble at a time */
+static const UNS16 HashCrcTable[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/**
+ * @ingroup eeprom
+ * @brief Adds n bytes to a CRC-16
+ */
+static UNS16 HashBytes( UNS16 crc, const UNS8 *data, UNS8 n )
+{
+  UNS8 i;
+  
+  for (i = 0; i < n; i++)
+  {
+    crc = (crc << 4) ^ HashCrcTable[(crc >> 12) ^ (data[i] >> 4)];
+    crc = (crc << 4) ^ HashCrcTable[(crc >> 12) ^ (data[i] & 0x0F)];
+  }
+  return crc;
+}
+
+/**
+ * @ingroup eeprom
+ * @brief CRC-16 of length bytes of EEPROM from address
+ */
+static UNS16 HashEEPROM( UINT16 address, UINT16 length )
+{
+  UNS16 crc = 0;
+  UNS8 data[8];
+  UNS8 n;
+  
+  while ( length )
+  {
+    n = (length < sizeof(data)) ? (UNS8)length : sizeof(data);
+    EEPROM_read( address, data, n );
+    crc = HashBytes( crc, data, n );
+    address += n;
+    length -= n;
+  }
+  return crc;
+}
+
+/**
+ * @ingroup eeprom
+ * @brief Hashes the set of slot hashes (0x2024.3)
+ */
+static void UpdatePatternSetHash( void )
+{
+  UNS16 crc = 0;
+  UNS8 i;
+  
+  for (i = 0; i < MAX_PATTERNS; i++)
   {
-    for (i = 0; i < 0x400/EEPROM_ERASE_SIZE; i++)
-      EEPROM_write(i*EEPROM_ERASE_SIZE, byteErase, EEPROM_ERASE_SIZE); 
+    crc = (crc << 4) ^ HashCrcTable[(crc >> 12) ^ ((UNS8)PatternHash[i] >> 4)];
+    crc = (crc << 4) ^ HashCrcTable[(crc >> 12) ^ ((UNS8)PatternHash[i] & 0x0F)];
+    crc = (crc << 4) ^ HashCrcTable[(crc >> 12) ^ (PatternHash[i] >> 12)];
+    crc = (crc << 4) ^ HashCrcTable[(crc >> 12) ^ ((PatternHash[i] >> 8) & 0x0F)];
   }
-  if( space!=1 ) 
+  PatternSetHash = crc;
+}
+
+/**
+ * @ingroup eeprom
+ * @brief Hashes the pattern slot again (0-based), and the set of slot hashes (0x2024.3)
+ */
+void UpdatePatternHash( UNS8 slot )
+{
+  if ( slot >= MAX_PATTERNS )
+    return;
+  PatternHash[slot] = HashEEPROM( PATTERNS_EEPROM_ADDRESS + BYTES_PER_PATTERN*(UINT16)slot, BYTES_PER_PATTERN );
+  UpdatePatternSetHash();
+}
+
+/**
+ * @ingroup eeprom
+ * @brief Has RunContentHashTask() hash every pattern slot, then the set of slot hashes once
+ */
+static void UpdatePatternHashes( void )
+{
+  hashRequest |= HASHJOB_PATTERNS;
+  ContentHash_Status = CONTENTHASH_BUSY;
+}
+
+/**
+ * @ingroup eeprom
+ * @brief Has RunContentHashTask() hash the restore image (0x2024.2): its size header and the
+ *        bytes recorded by SaveValues()
+ */
+static void UpdateRestoreHash( void )
+{
+  hashRequest |= HASHJOB_RESTORE;
+  ContentHash_Status = CONTENTHASH_BUSY;
+}
+
+/**
+ * @ingroup eeprom
+ * @brief Has every pattern slot and the restore image hashed, at startup and after raw EEPROM 
+ *        writes.  0x2024.4 reads CONTENTHASH_BUSY until RunContentHashTask() is done.
+ */
+void UpdateContentHashes( void )
+{
+  UpdatePatternHashes();
+  UpdateRestoreHash();
+}
+
+/**
+ * @ingroup eeprom
+ * @brief Main loop slice of the content hashes: up to 4 KB of EEPROM at roughly 60 cycles a
+ *        byte (~250ms at FOSC 1000), so hashed MEMCRC_CHUNK_BYTES at a time for MEMCRC_SLICE_US
+ *        per pass as the checksum job.  A request made while an item is hashed redoes it after.
+ */
+void RunContentHashTask( void )
+{
+  UNS8 data[MEMCRC_CHUNK_BYTES];
+  UNS8 n;
+  TIMEVAL start;
+  
+  if ( ContentHash_Status != CONTENTHASH_BUSY )
+    return;
+  
+  start = TimerGetTime();
+  do
   {
-    for (i = 0x400/EEPROM_ERASE_SIZE; i < 0x1000/EEPROM_ERASE_SIZE; i++)
-      EEPROM_write(i*EEPROM_ERASE_SIZE, byteErase, EEPROM_ERASE_SIZE);
+    if ( hashRemaining == 0 )                   // next item
+    {
+      hashCrc = 0;
+      if ( hashItem + 1 < MAX_PATTERNS )
+      {
+        hashItem++;
+        hashAddress = PATTERNS_EEPROM_ADDRESS + BYTES_PER_PATTERN*(UINT16)hashItem;
+        hashRemaining = BYTES_PER_PATTERN;
+      }
+      else if ( hashRequest & HASHJOB_PATTERNS )
+      {
+        hashRequest &= ~HASHJOB_PATTERNS;
+        hashItem = 0;
+        hashAddress = PATTERNS_EEPROM_ADDRESS;
+        hashRemaining = BYTES_PER_PATTERN;
+      }
+      else if ( hashRequest & HASHJOB_RESTORE )
+      {
+        hashRequest &= ~HASHJOB_RESTORE;
+        hashItem = MAX_PATTERNS;
+        EEPROM_read( 0, data, 2 );
+        hashAddress = 0;
+        hashRemaining = data[0] + ((UINT16)data[1] << 8);
+        if ( hashRemaining > PATTERNS_EEPROM_ADDRESS )
+          hashRemaining = PATTERNS_EEPROM_ADDRESS;
+        if ( hashRemaining < 2 )
+          hashRemaining = 2;
+      }
+      else
+      {
+        ContentHash_Status = CONTENTHASH_READY;
+        return;
+      }
+    }
+    
+    n = (hashRemaining < MEMCRC_CHUNK_BYTES) ? (UNS8)hashRemaining : MEMCRC_CHUNK_BYTES;
+    EEPROM_read( hashAddress, data, n );
+    hashCrc = HashBytes( hashCrc, data, n );
+    hashAddress += n;
+    hashRemaining -= n;
+    
+    if ( hashRemaining == 0 )
+    {
+      if ( hashItem < MAX_PATTERNS )
+      {
+        PatternHash[hashItem] = hashCrc;
+        if ( hashItem == MAX_PATTERNS - 1 )
+          UpdatePatternSetHash();
+      }
+      else
+        RestoreHash = hashCrc;
+    }
+  } while ( TIMEVAL_TO_US(TimerGetTime() - start) < MEMCRC_SLICE_US );
+}
+
+/**
+ * @ingroup eeprom
+ * @brief SDO stream of the pattern slot hashes (0x2024.1): 48 CRC-16, little endian, slot 1 first
+ */
+static UNS32 PatternHash_Read( CO_Data* d, const ODStream *stream, UNS32 offset, UNS8 *pData, UNS8 nbBytes )
+{
+  UNS8 i;
+  
+  for (i = 0; i < nbBytes; i++, offset++)
+    pData[i] = (UNS8)(PatternHash[offset >> 1] >> ((offset & 1) ? 8 : 0));
+  return 0;
+}
+
+const ODStream PatternHash_Stream = { sizeof(PatternHash), &PatternHash_Read, NULL };
+
+// checksum job, copied from the OD when started
+static UNS8  memCrcSelect;
+static UNS32 memCrcAddress;
+static UNS32 memCrcRemaining;
+static UNS32 memCrc;
+
+/* CRC-32 (IEEE 802.3, reflected 0xEDB88320), computed a nibble at a time */
+static const UNS32 MemCrcTable[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+/**
+ * @ingroup eeprom
+ * @brief OD callback of the checksum status (0x2023.4): writing MEMCRC_BUSY starts a CRC-32 of 
+ *        MemCrc_Length bytes (0 up to the end of the memory) of flash (MemCrc_Select 1) or 
+ *        EEPROM (4) from MemCrc_Address.  RunChecksumTask() computes it in slices.
+ */
+UNS32 MemCrc_Start( CO_Data* d, const indextable *unused_indextable, UNS8 unused_bSubindex )
+{
+  UNS32 memSize;
+  
+  if ( MemCrc_Status != MEMCRC_BUSY )
+    return OD_SUCCESSFUL;
+  
+  if ( MemCrc_Select == 1 )
+    memSize = MAX_FLASH_MEMORY;
+  else if ( MemCrc_Select == 4 )
+    memSize = MAX_EEPROM_MEMORY;
+  else
+    memSize = 0;
+  if ( MemCrc_Address >= memSize || MemCrc_Length > memSize - MemCrc_Address )
+  {
+    MemCrc_Status = MEMCRC_RANGE_ERROR;
+    return OD_VALUE_RANGE_EXCEEDED;
+  }
+  
+  memCrcSelect = MemCrc_Select;
+  memCrcAddress = MemCrc_Address;
+  memCrcRemaining = MemCrc_Length ? MemCrc_Length : memSize - MemCrc_Address;
+  memCrc = 0xFFFFFFFF;
+  MemCrc_Done = 0;
+  MemCrc_Result = 0;
+  return OD_SUCCESSFUL;
+}
+
+/**
+ * @ingroup eeprom
+ * @brief Main loop slice of the checksum job: adds MEMCRC_CHUNK_BYTES bytes at a time until
+ *        MEMCRC_SLICE_US have passed (measured on the alarm timebase, at least one chunk), and 
+ *        publishes the CRC in MemCrc_Result (0x2023.5) when done
+ */
+void RunChecksumTask( void )
+{
+  UNS8 data[MEMCRC_CHUNK_BYTES];
+  UNS8 n, i;
+  TIMEVAL start;
+  
+  if ( MemCrc_Status != MEMCRC_BUSY )
+    return;
+  
+  start = TimerGetTime();
+  do
+  {
+    n = (memCrcRemaining < MEMCRC_CHUNK_BYTES) ? (UNS8)memCrcRemaining : MEMCRC_CHUNK_BYTES;
+    if ( memCrcSelect == 1 )
+      for (i = 0; i < n; i++)
+        data[i] = *(UINT8 __farflash *)(memCrcAddress + i); 
+    else
+      EEPROM_read( (UINT16)memCrcAddress, data, n );
+    
+    for (i = 0; i < n; i++)
+    {
+      memCrc ^= data[i];
+      memCrc = (memCrc >> 4) ^ MemCrcTable[memCrc & 0x0F];
+      memCrc = (memCrc >> 4) ^ MemCrcTable[memCrc & 0x0F];
+    }
+    memCrcAddress += n;
+    memCrcRemaining -= n;
+    MemCrc_Done += n;
+  } while ( memCrcRemaining && TIMEVAL_TO_US(TimerGetTime() - start) < MEMCRC_SLICE_US );
+  
+  if ( memCrcRemaining == 0 )
+  {
+    MemCrc_Result = ~memCrc;
+    MemCrc_Status = MEMCRC_DONE;
   }
 }
 
@@ -301,53 +833,249 @@ void EraseEprom(UNS8 space)
 
 /**
  * @ingroup eeprom
- * @brief Writes bytes to a specified location in EEPROM
+ * @brief Queues bytes to be written to a specified location in EEPROM and returns; the EE_READY
+ *        interrupt writes them (~8.5ms each).  Each byte is compared first and only queued if it
+ *        changed.  Waits only when the queue is full.  Counted in EEStat_Written/Skipped (0x2025).
  * @param address The address, relative to the start of the EEPROM where the data will be written.
  * @param *data pointer to the data (or array) to be written
  * @param length length of data to be written
  */
 void EEPROM_write(UNS16 address, UNS8 * data, UNS16 length)
 {
-  PORTA |= 0x20; //PA.5
-	int i = 0;
-        while (length--)
-        {
-          while(EECR & (1<<EEWE));               
-          EEAR = address++; 
-          EEDR = data[i]; 
-          
-          DISABLE_INTERRUPTS();
-          EECR |= (1<<EEMWE); /* Write logical one to EEMWE */ 
-          EECR |= (1<<EEWE);  /* Start eeprom write by setting EEWE */ 
-          ENABLE_INTERRUPTS();
-          i++;
-          
-        }
-        PORTA &= ~0x20; //PA.5
+  UNS16 i, span;
+  UNS8 current;
 
+  for ( ; length--; address++, data++ )
+  {
+    EEPROM_read( address, &current, 1 );  /* compare before write */
+    DISABLE_INTERRUPTS();
+    if ( current == *data )
+      EEStat_Skipped++;
+    else
+    {
+      i = EEQueue_Find( address, &span );
+      if ( i == EEQUEUE_SIZE )
+        EEQueue_Put( address, *data );
+      else
+        eeQueueData[i] = *data;
+      EEQueue_Start();
+    }
+    ENABLE_INTERRUPTS();
+  }
 }
 
 
 /**
  * @ingroup eeprom
- * @brief Reads bytes from a specified location in EEPROM
+ * @brief Reads bytes from a specified location in EEPROM, including the bytes still queued by
+ *        EEPROM_write() and EraseEprom().  If the EEPROM itself has to be read while a write is
+ *        in progress, the queue is held until the read is done, so it waits for one write at most.
  * @param address The address, relative to the start of the EEPROM where the data will be written.
  * @param *data pointer to the data (or array) to read to
  * @param length length of data to be read
  */
 void EEPROM_read(UNS16 address, UNS8 * data, UNS16 length)
 {
+  UNS16 i, span, n, k;
+
   PORTA |= 0x20; //PA.5
-	while (length--)
-        {
-          while(EECR & (1<<EEWE));    /* Wait for completion of previous read */ 
-        
-          EEAR = address++; 
- 
-          EECR |= (1<<EERE);      
-          *(data++) = EEDR;
-        }
-PORTA &= ~0x20; //PA.5
+  while ( length )
+  {
+    DISABLE_INTERRUPTS();
+    i = EEQueue_Find( address, &span );
+    n = (length < EEPROM_READ_CHUNK) ? length : EEPROM_READ_CHUNK;
+    if ( span < n )
+      n = span;
+    if ( i != EEQUEUE_SIZE )
+    {
+      for (k = 0; k < n; k++)
+        data[k] = eeQueueData[(i + k) & (EEQUEUE_SIZE - 1)];
+    }
+    else if ( address >= eeEraseAddress && address < eeEraseEnd )
+    {
+      if ( eeEraseEnd - address < n )
+        n = eeEraseEnd - address;
+      memset( data, 0xFF, n );
+    }
+    else if ( EECR & (1<<EEWE) )
+      n = 0;
+    else
+    {
+      if ( address < eeEraseAddress && eeEraseAddress < eeEraseEnd && eeEraseAddress - address < n )
+        n = eeEraseAddress - address;
+      for (k = 0; k < n; k++)
+      {
+        EEAR = address + k;
+        EECR |= (1<<EERE);
+        data[k] = EEDR;
+      }
+    }
+    address += n;
+    data += n;
+    length -= n;
+    if ( !n )
+    {
+      EECR &= ~(1<<EERIE);  /* hold the queue, restarted below */
+      ENABLE_INTERRUPTS();
+      while ( EECR & (1<<EEWE) );  /* wait for completion of the write in progress */
+    }
+    else
+      ENABLE_INTERRUPTS();
+  }
+  DISABLE_INTERRUPTS();
+  EEQueue_Start();
+  ENABLE_INTERRUPTS();
+  PORTA &= ~0x20; //PA.5
+}
+
+
+/**
+ * @ingroup eeprom
+ * @brief Waits until every queued EEPROM write and erase is done, before a reset or a power cut
+ */
+void EEPROM_Flush( void )
+{
+  DISABLE_INTERRUPTS();
+  while ( EEQueue_Status != EEQUEUE_IDLE )
+    EEQueue_Wait();
+  ENABLE_INTERRUPTS();
+}
+
+
+/**
+ * @ingroup eeprom
+ * @brief Index in eeQueueData of the queued byte at address, EEQUEUE_SIZE if none.  Sets *span to
+ *        the number of bytes from address on that are queued in a row, or else that are not queued.
+ *        One pass over the runs.  Interrupts disabled.
+ */
+static UNS16 EEQueue_Find( UNS16 address, UNS16 *span )
+{
+  UNS16 index = eeQueueHead;
+  UNS16 offset;
+  UNS8 r, n;
+
+  *span = 0xFFFF;
+  for (n = 0, r = eeRunHead; n < eeRunCount; n++, r = (r + 1) & (EEQUEUE_RUNS - 1))
+  {
+    offset = address - eeRunAddress[r];
+    if ( offset < eeRunLength[r] )
+    {
+      *span = eeRunLength[r] - offset;
+      return (index + offset) & (EEQUEUE_SIZE - 1);
+    }
+    if ( eeRunAddress[r] > address && eeRunAddress[r] - address < *span )
+      *span = eeRunAddress[r] - address;
+    index += eeRunLength[r];
+  }
+  return EEQUEUE_SIZE;
+}
+
+
+/**
+ * @ingroup eeprom
+ * @brief Appends a byte that is not queued yet, to the last run if it follows it, else in a new run.
+ *        Waits while the ring or the run table is full.  Interrupts disabled.
+ */
+static void EEQueue_Put( UNS16 address, UNS8 data )
+{
+  UNS8 tail;
+
+  while ( eeQueueCount == EEQUEUE_SIZE )
+    EEQueue_Wait();
+  tail = (eeRunHead + eeRunCount - 1) & (EEQUEUE_RUNS - 1);
+  if ( !eeRunCount || eeRunAddress[tail] + eeRunLength[tail] != address || eeRunLength[tail] == 0xFF )
+  {
+    while ( eeRunCount == EEQUEUE_RUNS )
+      EEQueue_Wait();
+    tail = (eeRunHead + eeRunCount++) & (EEQUEUE_RUNS - 1);
+    eeRunAddress[tail] = address;
+    eeRunLength[tail] = 0;
+  }
+  eeQueueData[(eeQueueHead + eeQueueCount++) & (EEQUEUE_SIZE - 1)] = data;
+  eeRunLength[tail]++;
+}
+
+
+/**
+ * @ingroup eeprom
+ * @brief Enables the EE_READY interrupt if anything is left to write.  Interrupts disabled.
+ */
+static void EEQueue_Start( void )
+{
+  EEQueue_Pending = eeQueueCount + (eeEraseEnd - eeEraseAddress);
+  if ( EEQueue_Pending )
+  {
+    EEQueue_Status = EEQUEUE_BUSY;
+    EECR |= (1<<EERIE);
+  }
+}
+
+
+/**
+ * @ingroup eeprom
+ * @brief Handles one byte: the oldest queued byte, unless it lies in the erase still ahead, then the
+ *        next erased byte; the erase writes the queued byte in place of the 0xFF when it reaches it.
+ *        A byte that already holds its value is skipped without a write, so EEWE stays clear and the
+ *        interrupt fires again at once.  EEWE clear, interrupts disabled.
+ */
+static void EEQueue_Service( void )
+{
+  UNS16 address;
+  UNS8 data;
+
+  if ( eeRunCount && !(eeRunAddress[eeRunHead] > eeEraseAddress && eeRunAddress[eeRunHead] < eeEraseEnd) )
+  {
+    address = eeRunAddress[eeRunHead]++;
+    data = eeQueueData[eeQueueHead];
+    eeQueueHead = (eeQueueHead + 1) & (EEQUEUE_SIZE - 1);
+    eeQueueCount--;
+    if ( --eeRunLength[eeRunHead] == 0 )
+    {
+      eeRunHead = (eeRunHead + 1) & (EEQUEUE_RUNS - 1);
+      eeRunCount--;
+    }
+    if ( address == eeEraseAddress && eeEraseAddress < eeEraseEnd )
+      eeEraseAddress++;
+  }
+  else if ( eeEraseAddress < eeEraseEnd )
+  {
+    address = eeEraseAddress++;
+    data = 0xFF;
+  }
+  else
+  {
+    EECR &= ~(1<<EERIE);
+    EEQueue_Status = EEQUEUE_IDLE;
+    return;
+  }
+
+  EEAR = address;
+  EECR |= (1<<EERE);
+  if ( EEDR == data )
+    EEStat_Skipped++;
+  else
+  {
+    EEDR = data;
+    EECR |= (1<<EEMWE); /* Write logical one to EEMWE */
+    EECR |= (1<<EEWE);  /* Start eeprom write by setting EEWE */
+    EEStat_Written++;
+  }
+  EEQueue_Pending = eeQueueCount + (eeEraseEnd - eeEraseAddress);
+}
+
+
+/**
+ * @ingroup eeprom
+ * @brief Lets the pending interrupts in until the EEPROM is ready, then services the queue itself,
+ *        so it also progresses with the EE_READY interrupt held.  Interrupts disabled.
+ */
+static void EEQueue_Wait( void )
+{
+  ENABLE_INTERRUPTS();
+  while ( EECR & (1<<EEWE) );
+  DISABLE_INTERRUPTS();
+  if ( !(EECR & (1<<EEWE)) )
+    EEQueue_Service();
 }
 
 
@@ -355,6 +1083,16 @@ PORTA &= ~0x20; //PA.5
 //    INTERRUPT SERVICE ROUTINES
 //============================
 
+#pragma vector=EE_READY_vect
+/**
+ * @ingroup eeprom
+ * @brief EEPROM ready: writes the next queued byte.  Disabled when the queue is empty.
+ */
+__interrupt void EEPROM_ISR(void)
+{
+  EEQueue_Service();
+}
+
 
 //============================
 //    HARDWARE SPECIFIC CODE
@@ -14,9 +14,29 @@
 #define EEPROM_RECORD_SIZE      32
 #define EEPROM_ERASE_SIZE       32 //must be divisible into 4096 (4KB)
 
+#define EEQUEUE_SIZE            256    //bytes waiting for the EE_READY interrupt: restore image (182) + one pattern, power of 2
+#define EEQUEUE_RUNS            8      //runs of consecutive addresses in the queue, power of 2
+#define EEPROM_READ_CHUNK       4      //bytes read per critical section
+#define EEQUEUE_IDLE            0      //EEQueue_Status (0x2025.3)
+#define EEQUEUE_BUSY            1
+
 #define MAX_FLASH_MEMORY        0x020000 //(128KB)
 #define FLASH_RECORD_SIZE       32
 
+#define PATTERNS_EEPROM_ADDRESS 0x0400 //pattern area, up to the end of EEPROM (layout in stimTask.c)
+#define BYTES_PER_PATTERN       0x0040
+#define MAX_PATTERNS            48
+#define PATTERN_CRC_OFFSET      (BYTES_PER_PATTERN - 1) //last byte of a pattern: CRC-8 of the bytes before it
+
+#define MEMCRC_SLICE_US         1000   //time given to the checksum job per main loop pass
+#define MEMCRC_CHUNK_BYTES      8      //bytes between two looks at the time, ~0.4ms at FOSC 1000
+#define MEMCRC_IDLE             0      //MemCrc_Status (0x2023.4), write MEMCRC_BUSY to start a job
+#define MEMCRC_BUSY             1
+#define MEMCRC_DONE             2
+#define MEMCRC_RANGE_ERROR      3
+#define CONTENTHASH_READY       0      //ContentHash_Status (0x2024.4)
+#define CONTENTHASH_BUSY        1      //hashes of 0x2024 being computed, not valid yet
+
 // --------   DATA   ------------
 
 
@@ -31,6 +51,12 @@ void EraseEprom(UNS8);
 UNS8 ReadLocalFlashData( UNS32 nvAddress, UNS8 * data, UNS8 numData );
 void EEPROM_read(UNS16 address, UNS8 * data, UNS16 length);
 void EEPROM_write(UNS16 address, UNS8 * data, UNS16 length);
+void EEPROM_Flush( void );
+UNS8 PatternCRC( UNS8 crc, const UNS8 * data, UNS8 length );
+void RunChecksumTask( void );
+void UpdatePatternHash( UNS8 slot );
+void UpdateContentHashes( void );
+void RunContentHashTask( void );
 
 
 #endif
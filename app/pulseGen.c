@@ -369,6 +369,7 @@ volatile void StimPulse(UINT8 channel)
 	struct PulseDef *pulse;
 	UINT8 outPin;
         UINT8 analogComp;
+        UINT8 inReg;
 	UINT16 leEdge, trEdge, recharge, regMeas ;
 	
 	/* generate output pulses */
@@ -425,13 +426,19 @@ volatile void StimPulse(UINT8 channel)
                 if(regMeas)
                 {
                   if(BITS_TRUE(analogComp, B(ACO))) 
-                    Channel_InRegulation[ channel ] = 1;  
+                    inReg = 1;  
                   else
-                    Channel_InRegulation[ channel ] = 0;  
+                    inReg = 0;  
                 }
                 else
                 {
-                  Channel_InRegulation[ channel ] = 2;   
+                  inReg = 2;   
+                }
+                //Only a change is signalled to the event driven TPDOs
+                if(Channel_InRegulation[ channel ] != inReg)
+                {
+                  Channel_InRegulation[ channel ] = inReg;
+                  PDOMarkDirty(&ObjDict_Data, &Channel_InRegulation[ channel ]);
                 }
                 
 	}
@@ -15,6 +15,7 @@
 #include "can_AVR.h"
 #include "objdict.h"
 #include "runcanserver.h"
+#include "app.h"
 
 
 
@@ -25,6 +26,7 @@
 // --------  Static DATA   ------------
 // canOpen
 static Message m = Message_Initializer;
+static volatile UNS8 startupStaggerDone = 0;
 
 /******************************************/
 /*           Data                  */
@@ -37,36 +39,72 @@ unsigned char nodeID;
 /******************************************/
 /*           Prototypes                   */
 /******************************************/
-
+static void StartupStaggerAlarm( CO_Data* d, UNS32 id );
 
 
 /******************************************/
 /*           Tasks                   */
 /******************************************/
 
+/**
+ * @brief Starts the CAN controller, then staggers the entry into Waiting by 
+ * START_DELAY_MS*(nodeID-1) so heartbeats of a network powered up together 
+ * don't all start at once.  The CAN controller is receiving during the stagger and
+ * the main loop sleeps instead of busy waiting.
+ */
 void InitCANServerTask( void )
 {
         /* this sets the port info and resets the mob*/ 	
          canInit( CAN_BAUDRATE );  
-       /* Used to set the CAN server into waiting mode;  */  
-       setState( &ObjDict_Data, Waiting );
+       /* Used to set the CAN server into waiting mode, once the stagger expires  */  
+       if ( Status_NodeId <= 1 ||
+            SetAlarm( &ObjDict_Data, 0, &StartupStaggerAlarm, 
+                      MS_TO_TIMEVAL( START_DELAY_MS*(Status_NodeId-1) ), 0 ) == TIMER_NONE )
+         startupStaggerDone = 1;
 }
 
 
 void RunCANServerTask(void)
 {
-   /* a message was received; pass it to the CANopen stack */ 
+   /* drain every frame the CAN isr has queued; pass them to the CANopen stack */ 
   
-  if (canReceive( &m )) 	 	
+  while (canReceive( &m )) 	 	
   {			
     canDispatch( &ObjDict_Data, &m );	
     
   }
+  
+  TimerDispatchPending(); // runs the alarm callbacks that are due, here in the main loop
+  sendSDOblockPending( &ObjDict_Data ); // block upload segments held back by a full tx queue
+  
+  if ( startupStaggerDone )
+  {
+    startupStaggerDone = 0;
+    // an NMT command received during the stagger takes precedence
+    if ( getState( &ObjDict_Data ) == Unknown_state )
+      setState( &ObjDict_Data, Waiting );
+    RecordBootTime( &BootTime_Stagger );
+    BootTime_Total = BootTime_Restore + BootTime_Init + BootTime_Stagger;
+  }
   // update OD with mode state
-  Status_modeSelect = (UNS8)getState(&ObjDict_Data);
+  if ( Status_modeSelect != (UNS8)getState(&ObjDict_Data) )
+  {
+    Status_modeSelect = (UNS8)getState(&ObjDict_Data);
+    PDOMarkDirty( &ObjDict_Data, &Status_modeSelect );
+  }
   UpdateCANerrors();
+  UpdateSyncStatistics();
   
-  
+  // dirty TPDOs go out from the SYNC, event timer and inhibit paths, not at the loop rate
+}
+
+/**
+ * @brief alarm callback ending the startup stagger, run from the main loop by TimerDispatchPending;
+ *        Waiting is entered just after, in RunCANServerTask
+ */
+static void StartupStaggerAlarm( CO_Data* d, UNS32 id )
+{
+  startupStaggerDone = 1;
 }
 
 /**
@@ -37,7 +37,10 @@
 volatile UINT8 tickCount[4] = {0,0,0,0}, syncCount[4] = {0,0,0,0}, startPulse[4] = {0,0,0,0}, setupComplete[4] = {0,0,0,0};
 UINT8 vosTiming = 0;
 static UINT32 sysTimer;
+static volatile UINT8 sysTickStep = 1;   // ms added to sysTimer per tick, >1 while the tick is stretched
 UNS8 numScheduledStimChannels = 0;
+static s_sync_command syncCommand[2];    // double buffer, the isr fills the one not published
+static volatile UINT8 syncCommandFront = 0; // buffer holding the last SYNC command
 
 
 
@@ -112,6 +115,9 @@ void InitSchedulerOD(void)
 void SyncScheduler(void)
 {
 
+  if (sysTickStep != 1)
+    SetSchedulerTick(0); // SYNC arrived during a stretched tick, return to 1ms before anything is scheduled
+
   if (SyncPush < OCR0A)
   {
     TCNT0 = SyncPush; 
@@ -119,6 +125,67 @@ void SyncScheduler(void)
   
 }
 
+/**
+ *@brief Decodes the command bytes of a SYNC frame into the back buffer and publishes it.
+ *    Called from the CAN rx isr before syncPulse is set, so the stim tick that starts the
+ *    period always sees the X values sent with that period's SYNC.
+ *@param data SYNC payload
+ *@param len number of bytes in the payload
+*/
+void SyncLatchCommand(const unsigned char *data, unsigned char len)
+{
+  UINT8 back = syncCommandFront ^ 1;
+  s_sync_command *sc = &syncCommand[back];
+  UINT8 i;
+  
+  if (len > 8)
+    len = 8;
+  for (i = 0; i < len; i++)
+    sc->command[i] = data[i];
+  sc->len = len;
+  
+  sc->mapped = 0;
+  for (i = 0; i < NUM_CHANNELS; i++)
+  {
+    if (X_ChannelMap[i] > 0 && X_ChannelMap[i] <= len)
+    {
+      sc->x[i] = data[X_ChannelMap[i]-1]; //X_ChannelMap 1-based
+      sc->mapped |= 1 << i;
+    }
+  }
+  sc->seq = syncCommand[syncCommandFront].seq + 1;
+  
+  syncCommandFront = back;
+}
+
+/**
+ *@brief Switches timer 0 between the normal 1ms tick and a stretched tick used while 
+ *    the node is idle in Waiting/Stopped.  Only the prescaler changes, so OCR0A and
+ *    SyncPush keep their meaning.  The partial period in progress is counted at
+ *    the new rate, so sysTimer may be off by up to one stretched tick per switch.
+ *@param slow 1 for the stretched tick, 0 for the 1ms tick
+*/
+void SetSchedulerTick(unsigned char slow)
+{
+  UINT8 sreg = SREG;
+  
+  DISABLE_INTERRUPTS();
+  
+  TCCR0A &= ~(B(CS02) | B(CS01) | B(CS00));
+  if (slow)
+  {
+    TCCR0A |= TICK_PRESCALE_SLOW;
+    sysTickStep = SLOW_TICK_MS;
+  }
+  else
+  {
+    TCCR0A |= TICK_PRESCALE_FAST;
+    sysTickStep = 1;
+  }
+  
+  SREG = sreg;
+}
+
 //============================
 //    TIMER FOR ACCEL & TEMP
 //============================
@@ -150,12 +217,14 @@ UINT32 getSystemTime( void )
 __interrupt void stimTick_ISR(void)
 {
   UNS8 i;
-  static UNS8 channelsCompleted=0, initStimVOS=0, tick=0, dischargeCounter=0;
+  static UNS8 channelsCompleted=0, initStimVOS=0, tick=0, dischargeCounter=0, syncLatencyPending=0;
  
   //tick is used for AUTOSYNCS and controlling discharge switch.  Resets to 0 on SYNCs and AUTOSYNCSs 
            //(rolls over at 8bit=255ms if no SYNC/AUTOSYNC
   
-  sysTimer++ ; //used for 1ms accuracy system clock, free running (rolls over at 32bit = 1,193 hours)
+  sysTimer += sysTickStep ; //used for 1ms accuracy system clock, free running (rolls over at 32bit = 1,193 hours)
+  if (sysTickStep != 1)
+    LowPower_SleepTime += sysTickStep;
 
   //PORTE |= BIT0; //DEBUG ONLY set PE1 high
   
@@ -164,12 +233,27 @@ __interrupt void stimTick_ISR(void)
   {
       if( syncPulse)  //real SYNC pulse
       {
+        const s_sync_command *sc = &syncCommand[syncCommandFront];
+        
         AutoSyncCount = 0;
+        syncLatencyPending = 1;
+        
+        //this period uses the X values sent with its own SYNC
+        for( i=0; i<NUM_CHANNELS; i++)
+        {
+          if( sc->mapped & (1 << i) && X_Network[i] != sc->x[i] )
+          {
+            X_Network[i] = sc->x[i];
+            PDOMarkDirty( &ObjDict_Data, &X_Network[i] );
+          }
+        }
+        SyncStat_CommandSeq = sc->seq;
       }
       else  // AUTOSYNC pulse
       {
         AutoSyncCount++;
         TotalAutoSyncCount++;
+        syncLatencyPending = 0;
         if (AutoSyncCount > MaxAutoSyncCount)
         {
           MaxAutoSyncExceededCount++;
@@ -260,11 +344,26 @@ __interrupt void stimTick_ISR(void)
            PORTE &=~ BIT1; //DEBUG ONLY set PE1 low
 
            startPulse[i] = 0;  //done with this channel
+           
+           if(syncLatencyPending) //first pulse after a real SYNC
+           {
+             SyncStat_PulseLatency = (UNS32)(UNS16)(canTimerNow() - (UNS16)canSyncTimeStamp) * CAN_TIMER_TICK_US;
+             if(SyncStat_PulseLatency > SyncStat_MaxPulseLatency)
+               SyncStat_MaxPulseLatency = SyncStat_PulseLatency;
+             syncLatencyPending = 0;
+           }
            dischargeCounter = 0; //reset time needed for discharge
             
-           ActualStimTiming[i] = tickCount[i]; //indicate actual stim time
+           if(ActualStimTiming[i] != tickCount[i])
+           {
+             ActualStimTiming[i] = tickCount[i]; //indicate actual stim time
+             PDOMarkDirty( &ObjDict_Data, &ActualStimTiming[i] );
+           }
            if(tickCount[i] > MaxActualStimTiming[i])
+           {
              MaxActualStimTiming[i] = tickCount[i];
+             PDOMarkDirty( &ObjDict_Data, &MaxActualStimTiming[i] );
+           }
            
            //if this was our last scheduled channel, turn down VOS
            if(++channelsCompleted==numScheduledStimChannels) 
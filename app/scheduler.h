@@ -7,6 +7,26 @@
 // -------- DEFINITIONS ----------
 #define NUM_CHANNELS        4
 
+/* timer 0 prescaler for the normal 1ms tick and for the stretched low power tick */
+#if (FOSC == 1000)
+  #define TICK_PRESCALE_FAST  B(CS01)             // 1MHz/8 (8us), 1ms tick
+  #define TICK_PRESCALE_SLOW  (B(CS01) | B(CS00)) // 1MHz/64 (64us), 8ms tick
+  #define SLOW_TICK_MS        8
+#else
+  #define TICK_PRESCALE_FAST  (B(CS01) | B(CS00)) // 8MHz/64 (8us), 1ms tick
+  #define TICK_PRESCALE_SLOW  B(CS02)             // 8MHz/256 (32us), 4ms tick
+  #define SLOW_TICK_MS        4
+#endif
+
+/* SYNC command snapshot, filled by the CAN rx isr */
+typedef struct {
+  unsigned char command[8];       // SYNC payload
+  unsigned char len;
+  unsigned char x[NUM_CHANNELS];  // X per channel, decoded through X_ChannelMap
+  unsigned char mapped;           // bit n set when channel n has an X value in this SYNC
+  unsigned char seq;              // incremented for every SYNC
+} s_sync_command;
+
 // --------   DATA   ------------
 
 extern volatile unsigned char syncPulse;
@@ -17,6 +37,8 @@ extern volatile unsigned char setupComplete[4], startPulse[4];
 void InitScheduler( void );
 void InitSchedulerOD(void);
 void SyncScheduler(void);
+void SetSchedulerTick(unsigned char slow);
+void SyncLatchCommand(const unsigned char *data, unsigned char len);
 
 
 
@@ -32,11 +32,9 @@
 //  * x [20 bytes]
 //  * pw [20 bytes]
 //  * amp [20 bytes]
-//  * reserved [1 byte]
+//  * CRC-8 of the 63 bytes above [1 byte] (PatternCRC), checked when the slot is written at 0x3302
 
-#define PATTERNS_EEPROM_ADDRESS 0x0400
-#define BYTES_PER_PATTERN       0x0040
-#define MAX_PATTERNS            48
+// PATTERNS_EEPROM_ADDRESS, BYTES_PER_PATTERN and MAX_PATTERNS are in eedata.h
 
 // --------   DATA   ------------
 
@@ -131,6 +129,7 @@ void ClearActivePattern( UNS8 ch)
    memset(odPattern[ch].ampl, 0, PATTERN_ARRAYSIZE ); 
    
    ActiveFunctionGroups[ch] = 0;
+   PDOMarkDirty( &ObjDict_Data, &ActiveFunctionGroups[ch] );
 }
   
 /**
@@ -174,6 +173,8 @@ void UpdateActivePatterns ( UNS8 targetFunctionGroup, UNS8 active )
         //Read ChannelNumber from EEPROM
         addr = PATTERNS_EEPROM_ADDRESS + BYTES_PER_PATTERN*i;
         EEPROM_read(addr++, &channelNumber, 1);
+        if ( (channelNumber < 1) || (channelNumber > NUM_CHANNELS) )
+          continue; // empty slot, or invalidated by a failed SDO write
         
         if(active)
         {
@@ -186,12 +187,14 @@ void UpdateActivePatterns ( UNS8 targetFunctionGroup, UNS8 active )
           EEPROM_read(addr, odPattern[channelNumber - 1].ampl, PATTERN_ARRAYSIZE ); 
           
           ActiveFunctionGroups[channelNumber - 1] = functionGroup;
+          PDOMarkDirty( &ObjDict_Data, &ActiveFunctionGroups[channelNumber - 1] );
         }
         else
         {
           X_ChannelMap[channelNumber - 1] = 0;
           ClearActivePattern(channelNumber - 1); 
         }
+        PDOMarkDirty( &ObjDict_Data, &X_ChannelMap[channelNumber - 1] );
         
     }
     //PORTE &=~ BIT0; //DEBUG ONLY set PE1 low
@@ -204,6 +207,7 @@ void UpdateActivePatterns ( UNS8 targetFunctionGroup, UNS8 active )
 void TransferPatternEEPROM ( UNS8 patternID, UNS8 write )
 {
   UNS16 addr;
+  UNS8 crc;
    
   //Get the starting EEPROM address based on the patternID
   if( (patternID > 0) && (patternID <= MAX_PATTERNS) )
@@ -220,6 +224,16 @@ void TransferPatternEEPROM ( UNS8 patternID, UNS8 write )
       EEPROM_write(addr, pwValues_PatternTransfer, PATTERN_ARRAYSIZE);
         addr+=PATTERN_ARRAYSIZE;
       EEPROM_write(addr, ampValues_PatternTransfer, PATTERN_ARRAYSIZE);
+      
+      crc = PatternCRC(0, &channel_PatternTransfer, 1);
+      crc = PatternCRC(crc, &commandID_PatternTransfer, 1);
+      crc = PatternCRC(crc, &numPoints_PatternTransfer, 1);
+      crc = PatternCRC(crc, xValues_PatternTransfer, PATTERN_ARRAYSIZE);
+      crc = PatternCRC(crc, pwValues_PatternTransfer, PATTERN_ARRAYSIZE);
+      crc = PatternCRC(crc, ampValues_PatternTransfer, PATTERN_ARRAYSIZE);
+      addr+=PATTERN_ARRAYSIZE;
+      EEPROM_write(addr, &crc, 1);
+      UpdatePatternHash(patternID - 1);
     }
     else  //Read from EEPROM to OD
     {
@@ -309,6 +323,10 @@ volatile void runStimTask( UINT8 chan )
                                         Chan2_SetValues[1] = 0x00;
                                         Chan3_SetValues[1] = 0x00;
                                         Chan4_SetValues[1] = 0x00;	
+                                        PDOMarkDirtyRange( &ObjDict_Data, Chan1_SetValues, sizeof(Chan1_SetValues) );
+                                        PDOMarkDirtyRange( &ObjDict_Data, Chan2_SetValues, sizeof(Chan2_SetValues) );
+                                        PDOMarkDirtyRange( &ObjDict_Data, Chan3_SetValues, sizeof(Chan3_SetValues) );
+                                        PDOMarkDirtyRange( &ObjDict_Data, Chan4_SetValues, sizeof(Chan4_SetValues) );
                                         
 					break;
                                         
@@ -375,8 +393,13 @@ volatile void runStimTask( UINT8 chan )
 			frame.flag = configPulseChannel( chan, ampl, pw, ipi );
 			
                         
-			Y_Current[ y_index ]     = pw;
-			Y_Current[ y_index + 1 ] = ampl;
+			if( Y_Current[ y_index ] != pw || Y_Current[ y_index + 1 ] != ampl )
+			{
+				Y_Current[ y_index ]     = pw;
+				Y_Current[ y_index + 1 ] = ampl;
+				PDOMarkDirty( &ObjDict_Data, &Y_Current[ y_index ] );
+				PDOMarkDirty( &ObjDict_Data, &Y_Current[ y_index + 1 ] );
+			}
                         
 		
 	}
@@ -396,6 +419,10 @@ void InitStimTaskValues(void)
   Chan2_SetValues[1] = 0x00;
   Chan3_SetValues[1] = 0x00;
   Chan4_SetValues[1] = 0x00;
+  PDOMarkDirtyRange( &ObjDict_Data, Chan1_SetValues, sizeof(Chan1_SetValues) );
+  PDOMarkDirtyRange( &ObjDict_Data, Chan2_SetValues, sizeof(Chan2_SetValues) );
+  PDOMarkDirtyRange( &ObjDict_Data, Chan3_SetValues, sizeof(Chan3_SetValues) );
+  PDOMarkDirtyRange( &ObjDict_Data, Chan4_SetValues, sizeof(Chan4_SetValues) );
   
   for (i = 0; i < NUM_CHANNELS; i++)
   {
@@ -4,8 +4,13 @@
 #define STIMTASK_H
 
 
+#ifdef  __IAR_SYSTEMS_ICC__
 #define DISABLE_ANFON()         (PORTC &=~ BIT2)
 #define ENABLE_ANFON()          (PORTC |= BIT2)
+#else   // Linux host build
+#define DISABLE_ANFON()
+#define ENABLE_ANFON()
+#endif
 
 // -------- DEFINITIONS ----------
 
@@ -3,9 +3,11 @@
 #ifndef _SYS_H
 #define _SYS_H
 
+#ifdef  __IAR_SYSTEMS_ICC__
 #include <ioavr.h>
 #include <intrinsics.h>
 #include "iar.h"
+#endif
 
 
 #define OSC_FREQ	8000000L
@@ -44,9 +46,15 @@ typedef union
 #define SET_BITS(a,b)     ((a)|=(b))
 #define BITS_TRUE(a,b)    ((a)&(b))
 
+#ifdef  __IAR_SYSTEMS_ICC__
 #define ENABLE_INTERRUPTS()		asm("sei")
 #define DISABLE_INTERRUPTS()	asm("cli")
 #define RESET_WDOG()			asm("wdr")
+#else   // Linux host build (canFest/source/linux), no interrupts
+#define ENABLE_INTERRUPTS()
+#define DISABLE_INTERRUPTS()
+#define RESET_WDOG()
+#endif
 
 #define B(n)			(1<<(n))
 
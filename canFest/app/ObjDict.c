@@ -43,6 +43,50 @@ UNS8 AccelerometersFiltered[4] =
 INTEGER8 AccelerometersTilt[4] = 
 { 0x00,  0x00,  0x00, 0x00 };         /* Mapped at index 0x2011, subindex 0x01 */
 UNS8 AccelerometerSettings = 0;  /*0x2012*/
+UNS8 LowPower_Enable = 1;                       //2013.1  1 lets the node sleep with a stretched tick while in Waiting/Stopped
+UNS16 LowPower_SleepCount = 0;                  //2013.2  number of managed sleeps entered
+UNS32 LowPower_WakeLatency = 0;                 //2013.3  last CAN frame to main loop latency after a managed sleep (us)
+UNS32 LowPower_MaxWakeLatency = 0;              //2013.4  highest wake latency seen, us (write 0 to clear)
+UNS32 LowPower_SleepTime = 0;                   //2013.5  ms spent with the stretched tick
+UNS32 BootTime_Restore = 0;                     //2014.1  boot stage durations in us: EEPROM restore (or save)
+UNS32 BootTime_Init = 0;                        //2014.2  task, scheduler and CAN controller init
+UNS32 BootTime_Stagger = 0;                     //2014.3  node ID stagger until Waiting
+UNS32 BootTime_Total = 0;                       //2014.4  timer start to Waiting
+UNS32 SyncStat_Count = 0;                       //2015.1  SYNC frames received
+UNS32 SyncStat_Period = 0;                      //2015.2  last SYNC to SYNC period (us), from the CAN controller time stamps
+UNS32 SyncStat_AveragePeriod = 0;               //2015.3  running average period (us)
+UNS32 SyncStat_MinPeriod = 0;                   //2015.4  shortest period seen (write 0 to clear)
+UNS32 SyncStat_MaxPeriod = 0;                   //2015.5  longest period seen (write 0 to clear)
+UNS32 SyncStat_Jitter = 0;                      //2015.6  running average deviation from the reference period (us)
+UNS32 SyncStat_MaxJitter = 0;                   //2015.7  largest deviation seen (write 0 to clear)
+UNS16 SyncStat_LateCount = 0;                   //2015.8  periods longer than reference + LateMargin
+UNS16 SyncStat_MissingCount = 0;                //2015.9  SYNCs missing (period of 1.5 references or more)
+UNS32 SyncStat_PulseLatency = 0;                //2015.10 SYNC to first stim pulse (us)
+UNS32 SyncStat_MaxPulseLatency = 0;             //2015.11 highest SYNC to first pulse latency (write 0 to clear)
+UNS32 SyncStat_ExpectedPeriod = 0;              //2015.12 reference period (us), 0 uses the running average
+UNS32 SyncStat_LateMargin = 1000;               //2015.13 allowed lateness (us) before a period counts as late
+UNS8 SyncStat_CommandSeq = 0;                   //2015.14 sequence number of the SYNC whose X values drive the current period
+UNS32 SyncStat_TpdoTime = 0;                    //2015.15 time to build and send the TPDOs of the last SYNC (us)
+UNS32 SyncStat_MaxTpdoTime = 0;                 //2015.16 highest TPDO time (write 0 to clear)
+UNS32 TimerStat_DispatchLag = 0;                //2016.1  last alarm deadline to deferred callback lag (us)
+UNS32 TimerStat_MaxDispatchLag = 0;             //2016.2  highest dispatch lag (write 0 to clear)
+UNS32 TimerStat_DeferredCount = 0;              //2016.3  alarm callbacks run from the main loop
+UNS8 MemWindow_Select = 0x00;                  //2022.1  memory window: 1 flash, 4 EEPROM
+UNS32 MemWindow_Address = 0;                    //2022.2  first byte of the window
+UNS32 MemWindow_Length = 0;                     //2022.3  bytes in the window, 0 up to the end of the memory
+UNS8 MemCrc_Select = 0x00;                     //2023.1  checksum job memory: 1 flash, 4 EEPROM
+UNS32 MemCrc_Address = 0;                       //2023.2  first byte
+UNS32 MemCrc_Length = 0;                        //2023.3  bytes, 0 up to the end of the memory
+UNS8 MemCrc_Status = 0x00;                      //2023.4  write 1 to start; 0 idle, 1 busy, 2 done, 3 range error
+UNS32 MemCrc_Result = 0;                        //2023.5  CRC-32 of the range, when done
+UNS32 MemCrc_Done = 0;                          //2023.6  bytes checked so far
+UNS16 RestoreHash = 0;                          //2024.2  CRC-16 of the restore image in EEPROM
+UNS16 PatternSetHash = 0;                       //2024.3  CRC-16 of the 96 bytes of pattern slot hashes (2024.1)
+UNS8 ContentHash_Status = 0x01;                 //2024.4  0 hashes ready, 1 being computed (after boot and EEPROM writes)
+UNS32 EEStat_Written = 0;                       //2025.1  EEPROM bytes erased and written (write 0 to clear)
+UNS32 EEStat_Skipped = 0;                       //2025.2  EEPROM bytes left as they were, unchanged (write 0 to clear)
+UNS8 EEQueue_Status = 0;                        //2025.3  0 all EEPROM writes done, 1 writing in the background
+UNS16 EEQueue_Pending = 0;                      //2025.4  EEPROM bytes queued or still to erase
 UNS32 AddressRequest = 0x00000000;
 UNS8 memorySelect = 0x00;
 UNS8 triggerReadMemory = 0x00;
@@ -64,6 +108,11 @@ UNS16 CAN_Receive_BEI = 0x00;
 UNS16 CAN_Receive_Messages = 0x00;
 UNS16 CAN_Transmit_Messages = 0x00;
 UNS16 CAN_Interrupts_Off = 0x00;
+UNS16 CAN_RxQueueHighWater = 0x00;   /* most frames held by the rx ring buffer (write 0 to clear) */
+UNS16 CAN_RxQueueOverflows = 0x00;   /* frames dropped because the rx ring buffer was full */
+UNS16 CAN_TxQueueHighWater = 0x00;   /* most frames waiting in the tx queue (write 0 to clear) */
+UNS16 CAN_TxQueueDrops = 0x00;       /* frames dropped because the tx queue was full */
+UNS32 CAN_TxQueueMaxLatency = 0x00;  /* longest time a frame waited in the tx queue, us (write 0 to clear) */
 UNS8 DiagnosticsEnabled = 0x01;
 UNS8 Diagnostic_VIN = 0x00;
 UNS8 Diagnostic_VIC = 0x00;
@@ -291,6 +340,12 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                     UNS8 ObjDict_highestSubIndex_obj1200 = 2; /* number of subindex - 1*/
                     UNS32 ObjDict_obj1200_COB_ID_Client_to_Server_Receive_SDO = 0x602;	/* 1538 */
                     UNS32 ObjDict_obj1200_COB_ID_Server_to_Client_Transmit_SDO = 0x582;	/* 1410 */
+                    ODCallback_t ObjDict_Index1200_callbacks[] = 
+                     {
+                       NULL,
+                       &SDO_Server_Parameter_Callback,
+                       NULL,
+                     };
                     const subindex ObjDict_Index1200[] = 
                      {
                        { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj1200 },
@@ -298,6 +353,24 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                        { RO, uint32, sizeof (UNS32), (void*)&ObjDict_obj1200_COB_ID_Server_to_Client_Transmit_SDO }
                      };
 
+/* index 0x1201 :   Server SDO Parameter 2, for a second client (diagnostics monitor).
+   Invalid until the client COB-IDs are written through the default server at 0x1200. */
+                    UNS8 ObjDict_highestSubIndex_obj1201 = 2; /* number of subindex - 1*/
+                    UNS32 ObjDict_obj1201_COB_ID_Client_to_Server_Receive_SDO = 0x80000000;
+                    UNS32 ObjDict_obj1201_COB_ID_Server_to_Client_Transmit_SDO = 0x80000000;
+                    ODCallback_t ObjDict_Index1201_callbacks[] = 
+                     {
+                       NULL,
+                       &SDO_Server_Parameter_Callback,
+                       NULL,
+                     };
+                    const subindex ObjDict_Index1201[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj1201 },
+                       { RW, uint32, sizeof (UNS32), (void*)&ObjDict_obj1201_COB_ID_Client_to_Server_Receive_SDO },
+                       { RW, uint32, sizeof (UNS32), (void*)&ObjDict_obj1201_COB_ID_Server_to_Client_Transmit_SDO }
+                     };
+
 /* index 0x1400 :   Receive PDO 1 Parameter. */
                     UNS8 ObjDict_highestSubIndex_obj1400 = 5; /* number of subindex - 1*/
                     UNS32 ObjDict_obj1400_Source_Address = 0x0;	/* 387 */
@@ -305,6 +378,15 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                     UNS16 ObjDict_obj1400_Inhibit_Time = 0x0;	/* 0 */
                     UNS8 ObjDict_obj1400_Compatibility_Entry = 0x0;	/* 0 */
                     UNS16 ObjDict_obj1400_Event_Timer = 0x0;	/* 0 */
+                    ODCallback_t ObjDict_Index1400_callbacks[] = 
+                     {
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                     };
                     const subindex ObjDict_Index1400[] = 
                      {
                        { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj1400 },
@@ -329,6 +411,18 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                       0x00,	/* 0 */
                       0x00	/* 0 */
                     };
+                    ODCallback_t ObjDict_Index1600_callbacks[] = 
+                     {
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                     };
                     subindex ObjDict_Index1600[] = 
                      {
                        { RW, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj1600 },
@@ -384,6 +478,18 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                       0x00,	/* 0 */
                       0x00	/* 0 */
                     };
+                    ODCallback_t ObjDict_Index1A00_callbacks[] = 
+                     {
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                     };
                     const subindex ObjDict_Index1A00[] = 
                      {
                        { RW, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj1A00 },
@@ -474,6 +580,62 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                        { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2012 },
                        { RW, uint8, sizeof (UNS8), (void*) &AccelerometerSettings }
                      };
+
+/* index 0x2013 :   Mapped variable Power Management */
+                    UNS8 ObjDict_highestSubIndex_obj2013 = 5; /* number of subindex - 1*/
+                    const subindex ObjDict_Index2013[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2013 },
+                       { RW, uint8, sizeof (UNS8), (void*)&LowPower_Enable },
+                       { RO, uint16, sizeof (UNS16), (void*)&LowPower_SleepCount },
+                       { RO, uint32, sizeof (UNS32), (void*)&LowPower_WakeLatency },
+                       { RW, uint32, sizeof (UNS32), (void*)&LowPower_MaxWakeLatency },
+                       { RO, uint32, sizeof (UNS32), (void*)&LowPower_SleepTime }
+                     };
+
+/* index 0x2014 :   Mapped variable Boot Timing */
+                    UNS8 ObjDict_highestSubIndex_obj2014 = 4; /* number of subindex - 1*/
+                    const subindex ObjDict_Index2014[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2014 },
+                       { RO, uint32, sizeof (UNS32), (void*)&BootTime_Restore },
+                       { RO, uint32, sizeof (UNS32), (void*)&BootTime_Init },
+                       { RO, uint32, sizeof (UNS32), (void*)&BootTime_Stagger },
+                       { RO, uint32, sizeof (UNS32), (void*)&BootTime_Total }
+                     };
+
+/* index 0x2015 :   Mapped variable SYNC Statistics */
+                    UNS8 ObjDict_highestSubIndex_obj2015 = 16; /* number of subindex - 1*/
+                    const subindex ObjDict_Index2015[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2015 },
+                       { RO, uint32, sizeof (UNS32), (void*)&SyncStat_Count },
+                       { RO, uint32, sizeof (UNS32), (void*)&SyncStat_Period },
+                       { RO, uint32, sizeof (UNS32), (void*)&SyncStat_AveragePeriod },
+                       { RW, uint32, sizeof (UNS32), (void*)&SyncStat_MinPeriod },
+                       { RW, uint32, sizeof (UNS32), (void*)&SyncStat_MaxPeriod },
+                       { RO, uint32, sizeof (UNS32), (void*)&SyncStat_Jitter },
+                       { RW, uint32, sizeof (UNS32), (void*)&SyncStat_MaxJitter },
+                       { RW, uint16, sizeof (UNS16), (void*)&SyncStat_LateCount },
+                       { RW, uint16, sizeof (UNS16), (void*)&SyncStat_MissingCount },
+                       { RO, uint32, sizeof (UNS32), (void*)&SyncStat_PulseLatency },
+                       { RW, uint32, sizeof (UNS32), (void*)&SyncStat_MaxPulseLatency },
+                       { RW, uint32, sizeof (UNS32), (void*)&SyncStat_ExpectedPeriod },
+                       { RW, uint32, sizeof (UNS32), (void*)&SyncStat_LateMargin },
+                       { RO, uint8, sizeof (UNS8), (void*)&SyncStat_CommandSeq },
+                       { RO, uint32, sizeof (UNS32), (void*)&SyncStat_TpdoTime },
+                       { RW, uint32, sizeof (UNS32), (void*)&SyncStat_MaxTpdoTime }
+                     };
+
+/* index 0x2016 :   Mapped variable Timer Statistics */
+                    UNS8 ObjDict_highestSubIndex_obj2016 = 3; /* number of subindex - 1*/
+                    const subindex ObjDict_Index2016[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2016 },
+                       { RO, uint32, sizeof (UNS32), (void*)&TimerStat_DispatchLag },
+                       { RW, uint32, sizeof (UNS32), (void*)&TimerStat_MaxDispatchLag },
+                       { RO, uint32, sizeof (UNS32), (void*)&TimerStat_DeferredCount }
+                     };
                     
 /* index 0x2020 :   Mapped variable RecordTransfer */
                     UNS8 ObjDict_highestSubIndex_obj2020 = 7;
@@ -490,8 +652,81 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                       
                      };
                     
+/* index 0x2021 :   Mapped variable Memory Domains, streamed by the SDO server (see eedata.c) */
+                    UNS8 ObjDict_highestSubIndex_obj2021 = 2; /* number of subindex - 1*/
+                    const subindex ObjDict_Index2021[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2021 },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternArea_Stream },
+                       { RO, domain, sizeof (ODStream), (void*)&FlashImage_Stream }
+                     };
+
+/* index 0x2022 :   Mapped variable Memory Window, flash or EEPROM streamed from any address (see eedata.c) */
+                    UNS8 ObjDict_highestSubIndex_obj2022 = 4; /* number of subindex - 1*/
+                    ODCallback_t ObjDict_Index2022_callbacks[] = 
+                     {
+                       NULL,
+                       &MemWindow_Update,
+                       &MemWindow_Update,
+                       &MemWindow_Update,
+                       NULL,
+                     };
+                    const subindex ObjDict_Index2022[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2022 },
+                       { RW, uint8, sizeof (UNS8), (void*)&MemWindow_Select },
+                       { RW, uint32, sizeof (UNS32), (void*)&MemWindow_Address },
+                       { RW, uint32, sizeof (UNS32), (void*)&MemWindow_Length },
+                       { RW, domain, sizeof (ODStream), (void*)&MemWindow_Stream }
+                     };
+
+/* index 0x2023 :   Mapped variable Memory Checksum, CRC-32 computed in main loop slices (see eedata.c) */
+                    UNS8 ObjDict_highestSubIndex_obj2023 = 6; /* number of subindex - 1*/
+                    ODCallback_t ObjDict_Index2023_callbacks[] = 
+                     {
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       &MemCrc_Start,
+                       NULL,
+                       NULL,
+                     };
+                    const subindex ObjDict_Index2023[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2023 },
+                       { RW, uint8, sizeof (UNS8), (void*)&MemCrc_Select },
+                       { RW, uint32, sizeof (UNS32), (void*)&MemCrc_Address },
+                       { RW, uint32, sizeof (UNS32), (void*)&MemCrc_Length },
+                       { RW, uint8, sizeof (UNS8), (void*)&MemCrc_Status },
+                       { RO, uint32, sizeof (UNS32), (void*)&MemCrc_Result },
+                       { RO, uint32, sizeof (UNS32), (void*)&MemCrc_Done }
+                     };
+
+/* index 0x2024 :   Mapped variable Content Hashes, to resync only the pattern slots and restore image that changed */
+                    UNS8 ObjDict_highestSubIndex_obj2024 = 4; /* number of subindex - 1*/
+                    const subindex ObjDict_Index2024[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2024 },
+                       { RO, domain, sizeof (ODStream), (void*)&PatternHash_Stream },
+                       { RO, uint16, sizeof (UNS16), (void*)&RestoreHash },
+                       { RO, uint16, sizeof (UNS16), (void*)&PatternSetHash },
+                       { RO, uint8, sizeof (UNS8), (void*)&ContentHash_Status }
+                     };
+
+/* index 0x2025 :   Mapped variable EEPROM Statistics */
+                    UNS8 ObjDict_highestSubIndex_obj2025 = 4; /* number of subindex - 1*/
+                    const subindex ObjDict_Index2025[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2025 },
+                       { RW, uint32, sizeof (UNS32), (void*)&EEStat_Written },
+                       { RW, uint32, sizeof (UNS32), (void*)&EEStat_Skipped },
+                       { RO, uint8, sizeof (UNS8), (void*)&EEQueue_Status },
+                       { RO, uint16, sizeof (UNS16), (void*)&EEQueue_Pending }
+                     };
+                    
 /* index 0x2500 :   Mapped variable CAN */
-                    UNS8 ObjDict_highestSubIndex_obj2500 = 11; /* number of subindex - 1*/
+                    UNS8 ObjDict_highestSubIndex_obj2500 = 16; /* number of subindex - 1*/
                     const subindex ObjDict_Index2500[] = 
                      {
                        { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj2500 },
@@ -505,7 +740,12 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                        { RO, uint16, sizeof (UNS16), (void*)&CAN_Receive_BEI },
                        { RO, uint16, sizeof (UNS16), (void*)&CAN_Receive_Messages },
                        { RO, uint16, sizeof (UNS16), (void*)&CAN_Transmit_Messages },
-                       { RO, uint16, sizeof (UNS16),  (void*)&CAN_Interrupts_Off }
+                       { RO, uint16, sizeof (UNS16),  (void*)&CAN_Interrupts_Off },
+                       { RW, uint16, sizeof (UNS16), (void*)&CAN_RxQueueHighWater },
+                       { RO, uint16, sizeof (UNS16), (void*)&CAN_RxQueueOverflows },
+                       { RW, uint16, sizeof (UNS16), (void*)&CAN_TxQueueHighWater },
+                       { RO, uint16, sizeof (UNS16), (void*)&CAN_TxQueueDrops },
+                       { RW, uint32, sizeof (UNS32), (void*)&CAN_TxQueueMaxLatency }
                      };
                     
 /* index 0x2800 :   Mapped variable Scheduler settings*/
@@ -687,88 +927,157 @@ $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
                        { RW, uint8, PATTERN_ARRAYSIZE, (void*)&pwValues_PatternTransfer[0] },
                        { RW, uint8, PATTERN_ARRAYSIZE, (void*)&ampValues_PatternTransfer[0] }
                      };
+
+/* index 0x3302 :  Pattern Slots, one domain per EEPROM pattern record (layout in stimTask.c) */
+                    UNS8 ObjDict_highestSubIndex_obj3302 = 48; /* number of subindex - 1*/
+                    const subindex ObjDict_Index3302[] = 
+                     {
+                       { RO, uint8, sizeof (UNS8), (void*)&ObjDict_highestSubIndex_obj3302 },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[0] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[1] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[2] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[3] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[4] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[5] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[6] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[7] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[8] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[9] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[10] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[11] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[12] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[13] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[14] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[15] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[16] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[17] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[18] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[19] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[20] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[21] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[22] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[23] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[24] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[25] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[26] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[27] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[28] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[29] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[30] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[31] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[32] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[33] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[34] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[35] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[36] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[37] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[38] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[39] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[40] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[41] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[42] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[43] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[44] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[45] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[46] },
+                       { RW, domain, sizeof (ODStream), (void*)&PatternSlot_Stream[47] }
+                     };
                  
 /**************************************************************************/
 /* Declaration of variables                                       */
 /**************************************************************************/
 
+/* Every row of the object dictionary: its index and its callbacks, NULL if none.  Both tables
+   below are built from this one list, so they stay in step.  Must be sorted by index,
+   ObjDict_scanIndexOD searches it by bisection (smoke_test checks it) */
+#define ObjDict_ROWS \
+  ObjDict_ROW( 1000, NULL )                        \
+  ObjDict_ROW( 1001, NULL )                        \
+  ObjDict_ROW( 1006, NULL )                        \
+  ObjDict_ROW( 1008, NULL )                        \
+  ObjDict_ROW( 1017, ObjDict_Index1017_callbacks ) \
+  ObjDict_ROW( 1018, NULL )                        \
+  ObjDict_ROW( 1200, ObjDict_Index1200_callbacks ) \
+  ObjDict_ROW( 1201, ObjDict_Index1201_callbacks ) \
+  ObjDict_ROW( 1400, ObjDict_Index1400_callbacks ) \
+  ObjDict_ROW( 1600, ObjDict_Index1600_callbacks ) \
+  ObjDict_ROW( 1800, ObjDict_Index1800_callbacks ) \
+  ObjDict_ROW( 1A00, ObjDict_Index1A00_callbacks ) \
+  ObjDict_ROW( 2000, NULL )                        \
+  ObjDict_ROW( 2001, NULL )                        \
+  ObjDict_ROW( 2002, NULL )                        \
+  ObjDict_ROW( 2003, NULL )                        \
+  ObjDict_ROW( 2010, NULL )                        \
+  ObjDict_ROW( 2011, NULL )                        \
+  ObjDict_ROW( 2012, NULL )                        \
+  ObjDict_ROW( 2013, NULL )                        \
+  ObjDict_ROW( 2014, NULL )                        \
+  ObjDict_ROW( 2015, NULL )                        \
+  ObjDict_ROW( 2016, NULL )                        \
+  ObjDict_ROW( 2020, NULL )                        \
+  ObjDict_ROW( 2021, NULL )                        \
+  ObjDict_ROW( 2022, ObjDict_Index2022_callbacks ) \
+  ObjDict_ROW( 2023, ObjDict_Index2023_callbacks ) \
+  ObjDict_ROW( 2024, NULL )                        \
+  ObjDict_ROW( 2025, NULL )                        \
+  ObjDict_ROW( 2500, NULL )                        \
+  ObjDict_ROW( 2800, NULL )                        \
+  ObjDict_ROW( 2801, NULL )                        \
+  ObjDict_ROW( 2900, NULL )                        \
+  ObjDict_ROW( 3000, NULL )                        \
+  ObjDict_ROW( 3200, NULL )                        \
+  ObjDict_ROW( 3210, NULL )                        \
+  ObjDict_ROW( 3211, NULL )                        \
+  ObjDict_ROW( 3212, NULL )                        \
+  ObjDict_ROW( 3213, NULL )                        \
+  ObjDict_ROW( 3300, NULL )                        \
+  ObjDict_ROW( 3301, NULL )                        \
+  ObjDict_ROW( 3302, NULL )
+
+/* In RAM: const alone does not place data in flash under IAR, and the stack reads it through
+   CO_Data as a data pointer */
+#define ObjDict_ROW(index, callbacks) \
+  { (subindex*)ObjDict_Index##index, sizeof(ObjDict_Index##index)/sizeof(ObjDict_Index##index[0]), 0x##index },
 const indextable ObjDict_objdict[] = 
 {
-  { (subindex*)ObjDict_Index1000,sizeof(ObjDict_Index1000)/sizeof(ObjDict_Index1000[0]), 0x1000},
-  { (subindex*)ObjDict_Index1001,sizeof(ObjDict_Index1001)/sizeof(ObjDict_Index1001[0]), 0x1001},
-  { (subindex*)ObjDict_Index1006,sizeof(ObjDict_Index1006)/sizeof(ObjDict_Index1006[0]), 0x1006},
-  { (subindex*)ObjDict_Index1008,sizeof(ObjDict_Index1008)/sizeof(ObjDict_Index1008[0]), 0x1008},
-  { (subindex*)ObjDict_Index1017,sizeof(ObjDict_Index1017)/sizeof(ObjDict_Index1017[0]), 0x1017},
-  { (subindex*)ObjDict_Index1018,sizeof(ObjDict_Index1018)/sizeof(ObjDict_Index1018[0]), 0x1018},
-  { (subindex*)ObjDict_Index1200,sizeof(ObjDict_Index1200)/sizeof(ObjDict_Index1200[0]), 0x1200},
-  { (subindex*)ObjDict_Index1400,sizeof(ObjDict_Index1400)/sizeof(ObjDict_Index1400[0]), 0x1400},  
-  { (subindex*)ObjDict_Index1600,sizeof(ObjDict_Index1600)/sizeof(ObjDict_Index1600[0]), 0x1600}, 
-  { (subindex*)ObjDict_Index1800,sizeof(ObjDict_Index1800)/sizeof(ObjDict_Index1800[0]), 0x1800},
-  { (subindex*)ObjDict_Index1A00,sizeof(ObjDict_Index1A00)/sizeof(ObjDict_Index1A00[0]), 0x1A00},
-  { (subindex*)ObjDict_Index2000,sizeof(ObjDict_Index2000)/sizeof(ObjDict_Index2000[0]), 0x2000},
-  { (subindex*)ObjDict_Index2001,sizeof(ObjDict_Index2001)/sizeof(ObjDict_Index2001[0]), 0x2001},
-  { (subindex*)ObjDict_Index2002,sizeof(ObjDict_Index2002)/sizeof(ObjDict_Index2002[0]), 0x2002},
-  { (subindex*)ObjDict_Index2003,sizeof(ObjDict_Index2003)/sizeof(ObjDict_Index2003[0]), 0x2003},
-  { (subindex*)ObjDict_Index2010,sizeof(ObjDict_Index2010)/sizeof(ObjDict_Index2010[0]), 0x2010},
-  { (subindex*)ObjDict_Index2011,sizeof(ObjDict_Index2011)/sizeof(ObjDict_Index2011[0]), 0x2011},
-  { (subindex*)ObjDict_Index2012,sizeof(ObjDict_Index2012)/sizeof(ObjDict_Index2012[0]), 0x2012},
-  { (subindex*)ObjDict_Index2020,sizeof(ObjDict_Index2020)/sizeof(ObjDict_Index2020[0]), 0x2020},
-  { (subindex*)ObjDict_Index2500,sizeof(ObjDict_Index2500)/sizeof(ObjDict_Index2500[0]), 0x2500},
-  { (subindex*)ObjDict_Index2800,sizeof(ObjDict_Index2800)/sizeof(ObjDict_Index2800[0]), 0x2800},
-  { (subindex*)ObjDict_Index2801,sizeof(ObjDict_Index2801)/sizeof(ObjDict_Index2801[0]), 0x2801},
-  { (subindex*)ObjDict_Index2900,sizeof(ObjDict_Index2900)/sizeof(ObjDict_Index2900[0]), 0x2900},
-  { (subindex*)ObjDict_Index3000,sizeof(ObjDict_Index3000)/sizeof(ObjDict_Index3000[0]), 0x3000},
-  { (subindex*)ObjDict_Index3200,sizeof(ObjDict_Index3200)/sizeof(ObjDict_Index3200[0]), 0x3200},
-  { (subindex*)ObjDict_Index3210,sizeof(ObjDict_Index3210)/sizeof(ObjDict_Index3210[0]), 0x3210},
-  { (subindex*)ObjDict_Index3211,sizeof(ObjDict_Index3211)/sizeof(ObjDict_Index3211[0]), 0x3211},
-  { (subindex*)ObjDict_Index3212,sizeof(ObjDict_Index3212)/sizeof(ObjDict_Index3212[0]), 0x3212},
-  { (subindex*)ObjDict_Index3213,sizeof(ObjDict_Index3213)/sizeof(ObjDict_Index3213[0]), 0x3213},
-  { (subindex*)ObjDict_Index3300,sizeof(ObjDict_Index3300)/sizeof(ObjDict_Index3300[0]), 0x3300},
-  { (subindex*)ObjDict_Index3301,sizeof(ObjDict_Index3301)/sizeof(ObjDict_Index3301[0]), 0x3301}
+  ObjDict_ROWS
+};
+#undef ObjDict_ROW
+
+#define ObjDict_objdictCount (sizeof(ObjDict_objdict)/sizeof(ObjDict_objdict[0]))
+
+/* Callbacks of each row of ObjDict_objdict.  Only read here so kept in flash */
+#define ObjDict_ROW(index, callbacks) callbacks,
+static ODCallback_t * __flash const ObjDict_rowCallbacks[] = 
+{
+  ObjDict_ROWS
 };
+#undef ObjDict_ROW
 
+/**
+ * @brief Finds wIndex in ObjDict_objdict by bisection, and its callbacks if it has some
+ */
 const indextable * ObjDict_scanIndexOD (UNS16 wIndex, UNS32 * errorCode, ODCallback_t **callbacks)
 {
-	int i;
+	const indextable *row = ObjDict_objdict;
+	UNS8 count = ObjDict_objdictCount;
+	UNS8 half;
+
 	*callbacks = NULL;
-	switch(wIndex){
-		case 0x1000: i = 0;break;
-		case 0x1001: i = 1;break;
-                case 0x1006: i = 2;break;
-		case 0x1008: i = 3;break;
-		case 0x1017: i = 4;*callbacks = ObjDict_Index1017_callbacks; break;
-		case 0x1018: i = 5;break;
-		case 0x1200: i = 6;break;
-		case 0x1400: i = 7;break;	
-		case 0x1600: i = 8;break;	
-		case 0x1800: i = 9;*callbacks = ObjDict_Index1800_callbacks; break;	
-		case 0x1A00: i = 10;break;
-		case 0x2000: i = 11;break;
-		case 0x2001: i = 12;break;
-		case 0x2002: i = 13;break;
-		case 0x2003: i = 14;break;
-		case 0x2010: i = 15;break;
-		case 0x2011: i = 16;break;
-                case 0x2012: i = 17;break;
-                case 0x2020: i = 18;break;
-                case 0x2500: i = 19;break;
-                case 0x2800: i = 20;break;
-                case 0x2801: i = 21;break;
-                case 0x2900: i = 22;break;
-                case 0x3000: i = 23;break;
-                case 0x3200: i = 24;break;
-		case 0x3210: i = 25;break;
-		case 0x3211: i = 26;break;
-		case 0x3212: i = 27;break;
-		case 0x3213: i = 28;break;
-		case 0x3300: i = 29;break;
-                case 0x3301: i = 30;break;
-		default:
-			*errorCode = OD_NO_SUCH_OBJECT;
-			return NULL;
+	/* row stays on the last index <= wIndex */
+	while (count > 1) {
+		half = count >> 1;
+		if (row[half].index <= wIndex)
+			row += half;
+		count -= half;
+	}
+	if (row->index != wIndex) {
+		*errorCode = OD_NO_SUCH_OBJECT;
+		return NULL;
 	}
+	*callbacks = ObjDict_rowCallbacks[row - ObjDict_objdict];
 	*errorCode = OD_SUCCESSFUL;
-	return &ObjDict_objdict[i];
+	return row;
 }
 
 /* 
@@ -780,22 +1089,25 @@ const indextable * ObjDict_scanIndexOD (UNS16 wIndex, UNS32 * errorCode, ODCallb
 s_PDO_status ObjDict_PDO_status[1] = {s_PDO_status_Initializer};
 //s_PDO_status ObjDict_PDO_status[4] = {s_PDO_status_Initializer,s_PDO_status_Initializer,s_PDO_status_Initializer,s_PDO_status_Initializer};
 
+//Should match number of RPDOs!
+s_RPDO_status ObjDict_RPDO_status[1] = {s_RPDO_status_Initializer};
+
 const quick_index ObjDict_firstIndex = {
   6, /* SDO_SVR */
   0, /* SDO_CLT */
-  7, /* PDO_RCV */
-  8, /* PDO_RCV_MAP */
-  9, /* PDO_TRS */
-  10 /* PDO_TRS_MAP */
+  8, /* PDO_RCV */
+  9, /* PDO_RCV_MAP */
+  10, /* PDO_TRS */
+  11 /* PDO_TRS_MAP */
 };
 
 const quick_index ObjDict_lastIndex = {
-  6, /* SDO_SVR */
+  7, /* SDO_SVR */
   0, /* SDO_CLT */
-  7, /* PDO_RCV */
-  8, /* PDO_RCV_MAP */
-  9, /* PDO_TRS */
-  10 /* PDO_TRS_MAP */
+  8, /* PDO_RCV */
+  9, /* PDO_RCV_MAP */
+  10, /* PDO_TRS */
+  11 /* PDO_TRS_MAP */
 };
 
 const UNS16 ObjDict_ObjdictSize = sizeof(ObjDict_objdict)/sizeof(ObjDict_objdict[0]); 
@@ -50,11 +50,62 @@ extern UNS8 Accelerometers[4];		/* Mapped at index 0x2011, subindex 0x00*/
 extern UNS8 AccelerometersFiltered[4];      /* Mapped at index 0x2011, subindex 0x01 */
 extern INTEGER8 AccelerometersTilt[4];
 extern UNS8 AccelerometerSettings;  /*0x2012*/
+extern UNS8 LowPower_Enable;        /* Mapped at index 0x2013, subindex 0x01 */
+extern UNS16 LowPower_SleepCount;
+extern UNS32 LowPower_WakeLatency;
+extern UNS32 LowPower_MaxWakeLatency;
+extern UNS32 LowPower_SleepTime;
+extern UNS32 BootTime_Restore;      /* Mapped at index 0x2014, subindex 0x01 */
+extern UNS32 BootTime_Init;
+extern UNS32 BootTime_Stagger;
+extern UNS32 BootTime_Total;
+extern UNS32 SyncStat_Count;        /* Mapped at index 0x2015, subindex 0x01 */
+extern UNS32 SyncStat_Period;
+extern UNS32 SyncStat_AveragePeriod;
+extern UNS32 SyncStat_MinPeriod;
+extern UNS32 SyncStat_MaxPeriod;
+extern UNS32 SyncStat_Jitter;
+extern UNS32 SyncStat_MaxJitter;
+extern UNS16 SyncStat_LateCount;
+extern UNS16 SyncStat_MissingCount;
+extern UNS32 SyncStat_PulseLatency;
+extern UNS32 SyncStat_MaxPulseLatency;
+extern UNS32 SyncStat_ExpectedPeriod;
+extern UNS32 SyncStat_LateMargin;
+extern UNS8 SyncStat_CommandSeq;
+extern UNS32 SyncStat_TpdoTime;
+extern UNS32 SyncStat_MaxTpdoTime;
+extern UNS32 TimerStat_DispatchLag;  /* Mapped at index 0x2016, subindex 0x01 */
+extern UNS32 TimerStat_MaxDispatchLag;
+extern UNS32 TimerStat_DeferredCount;
 extern UNS32 AddressRequest;
 extern UNS8 memorySelect;
 extern UNS8 triggerReadMemory;
 extern UNS8 writeByteMemory;
 extern UNS8 statusByteMemory;
+extern const ODStream PatternArea_Stream;	/* Mapped at index 0x2021, subindex 0x01 */
+extern const ODStream FlashImage_Stream;	/* Mapped at index 0x2021, subindex 0x02 */
+extern const ODStream PatternSlot_Stream[];	/* Mapped at index 0x3302, subindex 0x01 - 0x30 */
+extern UNS8 MemWindow_Select;		/* Mapped at index 0x2022, subindex 0x01 */
+extern UNS32 MemWindow_Address;		/* Mapped at index 0x2022, subindex 0x02 */
+extern UNS32 MemWindow_Length;		/* Mapped at index 0x2022, subindex 0x03 */
+extern ODStream MemWindow_Stream;	/* Mapped at index 0x2022, subindex 0x04 */
+UNS32 MemWindow_Update(CO_Data* d, const indextable *unused_indextable, UNS8 unused_bSubindex);
+extern UNS8 MemCrc_Select;		/* Mapped at index 0x2023, subindex 0x01 */
+extern UNS32 MemCrc_Address;		/* Mapped at index 0x2023, subindex 0x02 */
+extern UNS32 MemCrc_Length;		/* Mapped at index 0x2023, subindex 0x03 */
+extern UNS8 MemCrc_Status;		/* Mapped at index 0x2023, subindex 0x04 */
+extern UNS32 MemCrc_Result;		/* Mapped at index 0x2023, subindex 0x05 */
+extern UNS32 MemCrc_Done;		/* Mapped at index 0x2023, subindex 0x06 */
+UNS32 MemCrc_Start(CO_Data* d, const indextable *unused_indextable, UNS8 unused_bSubindex);
+extern const ODStream PatternHash_Stream;	/* Mapped at index 0x2024, subindex 0x01 */
+extern UNS16 RestoreHash;		/* Mapped at index 0x2024, subindex 0x02 */
+extern UNS16 PatternSetHash;		/* Mapped at index 0x2024, subindex 0x03 */
+extern UNS8 ContentHash_Status;		/* Mapped at index 0x2024, subindex 0x04 */
+extern UNS32 EEStat_Written;		/* Mapped at index 0x2025, subindex 0x01 */
+extern UNS32 EEStat_Skipped;		/* Mapped at index 0x2025, subindex 0x02 */
+extern UNS8 EEQueue_Status;		/* Mapped at index 0x2025, subindex 0x03 */
+extern UNS16 EEQueue_Pending;		/* Mapped at index 0x2025, subindex 0x04 */
 extern UNS8 ReadMemoryData[36];
 extern UNS16 addressCounter;
 extern UNS16 CAN_FormErrors;
@@ -68,6 +119,11 @@ extern UNS16 CAN_Receive_BEI;
 extern UNS16 CAN_Receive_Messages;
 extern UNS16 CAN_Transmit_Messages;
 extern UNS16 CAN_Interrupts_Off;
+extern UNS16 CAN_RxQueueHighWater;
+extern UNS16 CAN_RxQueueOverflows;
+extern UNS16 CAN_TxQueueHighWater;
+extern UNS16 CAN_TxQueueDrops;
+extern UNS32 CAN_TxQueueMaxLatency;
 extern UNS16 RestoreList[9];
 extern UNS8 DiagnosticsEnabled;
 extern UNS8 Diagnostic_VIN;
@@ -50,14 +50,26 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #endif
 
 #define START_TX_MOB                    NB_RX_MOB
+// Receive MOb reserved for SYNC
+#define CAN_SYNC_MOB                    0
+// CAN timer prescaler, clkIO/(8*(CANTCON+1)) gives 8us ticks, the same as tmr3
+#define CAN_TIMER_PRESCALE              ((FOSC / 1000) - 1)
+#define CAN_TIMER_TICK_US               8
 #define TX_INT_MSK			((0x7F << (7 - NB_TX_MOB)) & 0x7F)
 
 
 /************************* To be called by user app ***************************/
 
+extern volatile unsigned char msg_received;
+extern volatile UNS16 canRxTimeStamp;
+extern UNS16 canReceiveTimeStamp;
+extern volatile UNS32 canSyncTimeStamp;
+
 unsigned char canInit(unsigned int bitrate);
 unsigned char canSend(CAN_PORT notused, Message *m);
 unsigned char canReceive(Message *m);
 unsigned char canChangeBaudRate_driver( CAN_HANDLE fd, char* baud);
 void UpdateCANerrors(void);
+UNS16 canTimerNow(void);
+void UpdateSyncStatistics(void);
 #endif
@@ -40,5 +40,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 void initTimer(void);
 UNS8 canSend(CAN_PORT notused, Message *m);
 UNS8 canChangeBaudRate(CAN_PORT port, char* baud);
+UNS8 canBaudRateSupported(char* baud);
+void canSetRxFilters(CO_Data* d);
 
 #endif
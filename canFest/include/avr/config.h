@@ -50,14 +50,19 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #define F_CPU          (1000UL*FOSC) // Need for AVR GCC
 #endif
 #define CAN_BAUDRATE    100
+#define CAN_RX_BUFFER_SIZE 16      // frames held by the CAN rx ring buffer, must be a power of 2 (<= 128)
+#define CAN_TX_QUEUE_SIZE  8       // frames queued while every tx MOb is busy
 
 // Needed defines by Canfestival lib
 #define MAX_CAN_BUS_ID 1
 #define SDO_MAX_LENGTH_TRANSFERT 50
-#define SDO_MAX_SIMULTANEOUS_TRANSFERTS 1
+#define SDO_MAX_SIMULTANEOUS_TRANSFERTS 2 // one line per SDO server, 0x1200 and 0x1201
+#define SDO_BUFFER_POOL_SIZE 2     // data buffers shared by the lines, may be fewer than the lines (streamed domains hold none)
 #define NMT_MAX_NODE_ID 127
 #define SDO_TIMEOUT_MS 1000U
-#define MAX_NB_TIMER 8
+#define SDO_BLOCK_SIZE 8           // segments per sub-block asked by the server in a block download (1..127)
+#define SDO_LEGACY_BLOCK_UPLOAD    // a block upload initiate without CRC (0xA0) is the JDC multi subindex upload
+#define MAX_NB_TIMER 16          // PDO event/inhibit, SDO, heartbeat, LSS, SYNC, EMCY and app alarms
 
 // CANOPEN_BIG_ENDIAN is not defined
 #define CANOPEN_LITTLE_ENDIAN 1
@@ -65,10 +70,13 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #define US_TO_TIMEVAL_FACTOR 8
 
 #define REPEAT_SDO_MAX_SIMULTANEOUS_TRANSFERTS_TIMES(repeat)\
-repeat
+repeat repeat
 #define REPEAT_NMT_MAX_NODE_ID_TIMES(repeat)\
 repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat
 
+#define CO_ENABLE_LSS              // LSS slave, used to change the bit rate at run time
+#define LSS_TIMEOUT_MS 1000
+#define LSS_FS_TIMEOUT_MS 100
 #define EMCY_MAX_ERRORS 8
 #define REPEAT_EMCY_MAX_ERRORS_TIMES(repeat)\
 repeat repeat repeat repeat repeat repeat repeat repeat
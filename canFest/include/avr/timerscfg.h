@@ -34,31 +34,43 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 // TIMEVAL is not at least on 32 bits
 #define TIMEVAL UNS32
 
-// The timer of the AVR counts from 0000 to 0xFFFF in CTC mode (it can be
-// shortened setting OCR3A eg. to get 2ms instead of 2.048ms)
-#define TIMEVAL_MAX 0xFFFF
+// tmr3 runs free (normal mode) and its overflows are counted in software, so
+// TIMEVAL is a 32 bit timebase.  The longest alarm, 2.3 hours at 8us ticks, stays
+// well inside the half range over which timer.c compares deadlines.
+#define TIMEVAL_MAX 0x3FFFFFFFUL
 
+// tmr3 tick in us: CKio/64 at 8, 4 and 2 MHz, CKio/8 at 1 MHz (see initTimer)
 #if (FOSC == 8000)
-// The timer is incrementing every 8 us at 8 Mhz/64 clock.
-#define MS_TO_TIMEVAL(ms) ((ms) * 125UL) //JML added UL otherwise may overflow
-#define US_TO_TIMEVAL(us) ((us)>>3)
+#define TIMER_TICK_US 8
 #endif
 #if (FOSC == 4000)
-// The timer is incrementing every 16 us at 4 Mhz/64 clock.
-// clock will be slightly slow (63/62.5=1.008)*ms
-#define MS_TO_TIMEVAL(ms) ((ms) * 63UL) //JML added UL otherwise may overflow
-#define US_TO_TIMEVAL(us) ((us)>>4)
+#define TIMER_TICK_US 16
 #endif
 #if (FOSC == 2000)
-// The timer is incrementing every 32 us at 2 Mhz/64 clock
-// clock will be slightly fast (31/31.25=0.996)*ms
-#define MS_TO_TIMEVAL(ms) ((ms) * 31UL) //JML added UL otherwise may overflow
-#define US_TO_TIMEVAL(us) ((us)>>5)
+#define TIMER_TICK_US 32
 #endif
 #if (FOSC == 1000)
-// The timer is incrementing every 8 us at 1 Mhz/8 clock
-#define MS_TO_TIMEVAL(ms) ((ms) * 125UL) //JML added UL otherwise may overflow
-#define US_TO_TIMEVAL(us) ((us)>>3)
+#define TIMER_TICK_US 8
 #endif
 
+// Scaled through us and rounded to the nearest tick: 1000 ms is exactly 62500 ticks
+// at 16us, where a per-ms factor of 63 ran 0.8% slow
+#define MS_TO_TIMEVAL(ms) (((ms) * 1000UL + TIMER_TICK_US / 2) / TIMER_TICK_US)
+#define US_TO_TIMEVAL(us) (((us) + TIMER_TICK_US / 2) / TIMER_TICK_US)
+#define TIMEVAL_TO_US(t) ((t) * (UNS32)TIMER_TICK_US)
+
+// Protects the timer queue against the tmr3 isr, also safe inside an isr
+#define TIMER_LOCK_T            unsigned char
+#define TIMER_LOCK(sreg)        { (sreg) = SREG; __disable_interrupt(); }
+#define TIMER_UNLOCK(sreg)      { SREG = (sreg); }
+
+// Shortest alarm that is programmed: covers the cycles between reading TCNT3 and
+// writing OCR3B (or the overflow isr arming the compare), so a compare point is 
+// never set behind the counter
+#define TIMER_MIN_ALARM         32
+
+// Callbacks allowed to stay in the tmr3 isr (SetAlarmIsrCallback), all others run
+// from the main loop through TimerDispatchPending
+#define TIMER_MAX_ISR_CALLBACKS 4
+
 #endif
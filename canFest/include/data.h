@@ -64,6 +64,7 @@ struct struct_CO_Data {
 	UNS8 *bDeviceNodeId;
 	const indextable *objdict;
 	s_PDO_status *PDO_status;
+	s_RPDO_status *RPDO_status;
 	const quick_index *firstIndex;
 	const quick_index *lastIndex;
 	const UNS16 *ObjdictSize;
@@ -72,6 +73,7 @@ struct struct_CO_Data {
 	
 	/* SDO */
 	s_transfer transfers[SDO_MAX_SIMULTANEOUS_TRANSFERTS];
+	UNS8 sdoBuffers[SDO_BUFFER_POOL_SIZE][SDO_MAX_LENGTH_TRANSFERT];
 	/* s_sdo_parameter *sdo_parameters; */
 
 	/* State machine */
@@ -143,10 +145,19 @@ struct struct_CO_Data {
 		0,          /* subIndex */\
 		0,          /* count */\
 		0,          /* offset */\
-		{0},        /* data (static use, so that all the table is initialize at 0)*/\
+		NULL,       /* data */\
 		0,          /* dataType */\
 		-1,         /* timer */\
-		NULL        /* Callback */\
+		NULL,       /* Callback */\
+		0,          /* blksize */\
+		0,          /* seqno */\
+		0,          /* crcOn */\
+		0,          /* blockStart */\
+		0,          /* crc */\
+		0,          /* crcCount */\
+		0,          /* holding */\
+		{0},        /* held */\
+		NULL        /* stream */\
 	  },
 
 #define ERROR_DATA_INITIALIZER \
@@ -204,6 +215,7 @@ struct struct_CO_Data {
 	& NODE_PREFIX ## _bDeviceNodeId,     /* bDeviceNodeId */\
 	NODE_PREFIX ## _objdict,             /* objdict  */\
 	NODE_PREFIX ## _PDO_status,          /* PDO_status */\
+	NODE_PREFIX ## _RPDO_status,         /* RPDO_status */\
 	& NODE_PREFIX ## _firstIndex,        /* firstIndex */\
 	& NODE_PREFIX ## _lastIndex,         /* lastIndex */\
 	& NODE_PREFIX ## _ObjdictSize,       /* ObjdictSize */\
@@ -214,6 +226,7 @@ struct struct_CO_Data {
 	{\
           REPEAT_SDO_MAX_SIMULTANEOUS_TRANSFERTS_TIMES(s_transfer_Initializer)\
 	},\
+	{{0}},      /* sdoBuffers */\
 	\
 	/* State machine*/\
 	Unknown_state,            /* default nodeState */\
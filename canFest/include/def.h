@@ -48,9 +48,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 #define SDOABT_TOGGLE_NOT_ALTERNED   0x05030000
 #define SDOABT_TIMED_OUT             0x05040000
+#define SDOABT_CS_NOT_VALID          0x05040001 /* Client/server command specifier not valid */
+#define SDOABT_INVALID_BLOCK_SIZE    0x05040002 /* Block mode only */
+#define SDOABT_INVALID_SEQUENCE      0x05040003 /* Block mode only */
+#define SDOABT_CRC_ERROR             0x05040004 /* Block mode only */
 #define SDOABT_OUT_OF_MEMORY         0x05040005 /* Size data exceed SDO_MAX_LENGTH_TRANSFERT */
 #define SDOABT_GENERAL_ERROR         0x08000000 /* Error size of SDO message */
+#define SDOABT_DATA_NOT_STORED       0x08000020 /* Data can not be transferred or stored to the application */
 #define SDOABT_LOCAL_CTRL_ERROR      0x08000021
+#define SDOABT_DEVICE_STATE          0x08000022 /* Not allowed in the present device state */
 #define SDOABT_APP_TIMEOUT           0x08000040 
 
 /******************** CONSTANTS ****************/
@@ -84,6 +90,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #define	SDO_ABORTED_INTERNAL     0x85     /* Aborted but not because of an abort message (Timeout) */
 #define	SDO_DOWNLOAD_IN_PROGRESS 0x2 
 #define	SDO_UPLOAD_IN_PROGRESS   0x3
+#define	SDO_BLOCK_DOWNLOAD_IN_PROGRESS 0x4 /* receiving the segments of a sub-block */
+#define	SDO_BLOCK_DOWNLOAD_END   0x5      /* last segment received, waiting the end request */
+#define	SDO_BLOCK_UPLOAD_INIT    0x6      /* initiate response sent, waiting the start */
+#define	SDO_BLOCK_UPLOAD_IN_PROGRESS 0x7  /* sub-block sent, waiting its acknowledge */
+#define	SDO_BLOCK_UPLOAD_END     0x8      /* end request sent, waiting the end response */
 
 
 /* Status of the node during the SDO transfer : */
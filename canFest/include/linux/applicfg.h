@@ -0,0 +1,90 @@
+/*
+This file is part of CanFestival, a library implementing CanOpen Stack.
+
+Copyright (C): Edouard TISSERANT and Francis DUPIN
+Linux host port for the rmStim node
+
+See COPYING file for copyrights details.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file   applicfg.h
+ * @brief Types and message macros for the Linux host build.  Fixed width types keep
+ *        UNS32 at 4 bytes, as on the AVR, so OD object sizes are the same.
+*/
+
+#ifndef __APPLICFG_LINUX__
+#define __APPLICFG_LINUX__
+
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+// Integers
+#define INTEGER8 int8_t
+#define INTEGER16 int16_t
+#define INTEGER24
+#define INTEGER32 int32_t
+#define INTEGER40
+#define INTEGER48
+#define INTEGER56
+#define INTEGER64 int64_t
+
+// Unsigned integers
+#define UNS8   uint8_t
+#define UNS16  uint16_t
+#define UNS32  uint32_t
+/*
+#define UNS24
+#define UNS40
+#define UNS48
+#define UNS56
+*/
+#define UNS64  uint64_t
+
+// Reals
+#define REAL32	float
+#define REAL64 double
+
+// IAR memory attributes, all data is in one address space on the host
+#define __flash
+
+#include "can.h"
+
+/// Definition of MSG_ERR
+// ---------------------
+#ifdef DEBUG_ERR_CONSOLE_ON
+#define MSG_ERR(num, str, val)      \
+          fprintf(stderr, "0x%04X %s 0x%lX\n", (unsigned)(num), (str), (unsigned long)(val))
+#else
+#    define MSG_ERR(num, str, val)
+#endif
+
+/// Definition of MSG_WAR
+// ---------------------
+#ifdef DEBUG_WAR_CONSOLE_ON
+#define MSG_WAR(num, str, val)      \
+          fprintf(stderr, "0x%04X %s 0x%lX\n", (unsigned)(num), (str), (unsigned long)(val))
+#else
+#    define MSG_WAR(num, str, val)
+#endif
+
+typedef void* CAN_HANDLE;
+
+typedef void* CAN_PORT;
+
+#endif
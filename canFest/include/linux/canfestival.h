@@ -0,0 +1,50 @@
+/*
+This file is part of CanFestival, a library implementing CanOpen Stack.
+
+Copyright (C): Edouard TISSERANT and Francis DUPIN
+Linux host port for the rmStim node
+
+See COPYING file for copyrights details.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file   canfestival.h
+ * @brief Driver entry points for the Linux host build (SocketCAN and a polled timer).
+ *        The stack side matches include/avr/canfestival.h.
+*/
+
+#ifndef __CAN_CANFESTIVAL__
+#define __CAN_CANFESTIVAL__
+
+#include "applicfg.h"
+#include "data.h"
+
+// ---------  to be called by user app ---------
+void initTimer(void);
+UNS8 canSend(CAN_PORT notused, Message *m);
+UNS8 canChangeBaudRate(CAN_PORT port, char* baud);
+void canSetRxFilters(CO_Data* d);
+UNS8 canBaudRateSupported(char* baud);
+
+// ---------  host only ---------
+unsigned char canInit(unsigned int bitrate);
+unsigned char canReceive(Message *m);
+int canGetFd(void);
+void TimerPoll(void);
+int TimerWaitMs(void);
+
+#endif
@@ -0,0 +1,70 @@
+/*
+This file is part of CanFestival, a library implementing CanOpen Stack.
+
+Copyright (C): Edouard TISSERANT and Francis DUPIN
+Linux host port for the rmStim node
+
+See COPYING file for copyrights details.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file   config.h
+ * @brief Stack configuration for the Linux host build.  The CanFestival settings
+ *        match include/avr/config.h so the same ObjDict.c can be used on the host.
+*/
+
+#ifndef _CONFIG_H_
+#define _CONFIG_H_
+
+#include <stdint.h>
+
+/* the host timer runs in the same 8us ticks as tmr3 at FOSC 1000 */
+#define FOSC           1000
+#define CAN_BAUDRATE    100
+#define CAN_IFNAME     "vcan0"     // default SocketCAN interface, overridden by $CAN_IFNAME
+
+// Needed defines by Canfestival lib
+#define MAX_CAN_BUS_ID 1
+#define SDO_MAX_LENGTH_TRANSFERT 50
+#define SDO_MAX_SIMULTANEOUS_TRANSFERTS 2 // one line per SDO server, 0x1200 and 0x1201
+#define SDO_BUFFER_POOL_SIZE 2     // data buffers shared by the lines, may be fewer than the lines (streamed domains hold none)
+#define NMT_MAX_NODE_ID 127
+#define SDO_TIMEOUT_MS 1000U
+#define SDO_BLOCK_SIZE 8           // segments per sub-block asked by the server in a block download (1..127)
+#define SDO_LEGACY_BLOCK_UPLOAD    // a block upload initiate without CRC (0xA0) is the JDC multi subindex upload
+#ifndef MAX_NB_TIMER             // timer_bench builds timer.c at several sizes
+#define MAX_NB_TIMER 16          // PDO event/inhibit, SDO, heartbeat, LSS, SYNC, EMCY and app alarms
+#endif
+
+// CANOPEN_BIG_ENDIAN is not defined
+#define CANOPEN_LITTLE_ENDIAN 1
+
+#define US_TO_TIMEVAL_FACTOR 8
+
+#define REPEAT_SDO_MAX_SIMULTANEOUS_TRANSFERTS_TIMES(repeat)\
+repeat repeat
+#define REPEAT_NMT_MAX_NODE_ID_TIMES(repeat)\
+repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat repeat
+
+#define CO_ENABLE_LSS              // LSS slave, used to change the bit rate at run time
+#define LSS_TIMEOUT_MS 1000
+#define LSS_FS_TIMEOUT_MS 100
+#define EMCY_MAX_ERRORS 8
+#define REPEAT_EMCY_MAX_ERRORS_TIMES(repeat)\
+repeat repeat repeat repeat repeat repeat repeat repeat
+
+#endif /* _CONFIG_H_ */
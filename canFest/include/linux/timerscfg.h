@@ -0,0 +1,53 @@
+/*
+This file is part of CanFestival, a library implementing CanOpen Stack.
+
+Copyright (C): Edouard TISSERANT and Francis DUPIN
+Linux host port for the rmStim node
+
+See COPYING file for copyrights details.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file   timerscfg.h
+ * @brief Timer configuration for the Linux host build, 8us ticks as tmr3 at FOSC 1000
+ */
+
+#ifndef __TIMERSCFG_H__
+#define __TIMERSCFG_H__
+
+#define TIMEVAL UNS32
+
+// same range as the extended tmr3 timebase, so alarm scheduling behaves as on the target
+#define TIMEVAL_MAX 0x3FFFFFFFUL
+
+// The timer is incrementing every 8 us
+#define TIMER_TICK_US 8
+#define MS_TO_TIMEVAL(ms) (((ms) * 1000UL + TIMER_TICK_US / 2) / TIMER_TICK_US)
+#define US_TO_TIMEVAL(us) (((us) + TIMER_TICK_US / 2) / TIMER_TICK_US)
+#define TIMEVAL_TO_US(t) ((t) * (UNS32)TIMER_TICK_US)
+
+// The host timer is polled from the main loop, nothing to lock
+#define TIMER_LOCK_T            int
+#define TIMER_LOCK(sreg)        { (void)(sreg); }
+#define TIMER_UNLOCK(sreg)      { (void)(sreg); }
+
+#define TIMER_MIN_ALARM         1
+
+// TimerPoll already runs in the main loop, the whitelist only skips the deferral
+#define TIMER_MAX_ISR_CALLBACKS 4
+
+#endif
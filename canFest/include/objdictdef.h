@@ -119,6 +119,24 @@ typedef struct s_quick_index{
 
 /*typedef struct struct_CO_Data CO_Data; */
 typedef UNS32 (*ODCallback_t)(CO_Data* d, const indextable *, UNS8 bSubindex);
+
+/* A domain entry points to a stream instead of a variable. The SDO server moves 
+   its data a segment at a time through these functions, with no copy in the 
+   transfer line, so the domain may be larger than SDO_MAX_LENGTH_TRANSFERT.
+   They return 0 or an SDO abort code. write is called with nbBytes = 0 at the end 
+   of a download, offset being then the number of bytes written. An aborted 
+   download gets no such call. The stream is passed, so that one pair of functions 
+   may serve a table of streams. */
+typedef struct td_ODStream ODStream;
+typedef UNS32 (*ODStreamRead_t)(CO_Data* d, const ODStream *stream, UNS32 offset, UNS8 *pData, UNS8 nbBytes);
+typedef UNS32 (*ODStreamWrite_t)(CO_Data* d, const ODStream *stream, UNS32 offset, const UNS8 *pData, UNS8 nbBytes);
+
+struct td_ODStream
+{
+    UNS32                   size;      /* The size (in Byte) of the domain */
+    ODStreamRead_t          read;      /* NULL if the domain can not be uploaded */
+    ODStreamWrite_t         write;     /* NULL if the domain can not be downloaded */
+};
 typedef const indextable * (*scanIndexOD_t)(UNS16 wIndex, UNS32 * errorCode, ODCallback_t **Callback);
 
 /************************** MACROS *********************************/
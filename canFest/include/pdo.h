@@ -37,6 +37,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "can.h"
 
 typedef struct struct_s_PDO_status s_PDO_status;
+typedef struct struct_s_RPDO_status s_RPDO_status;
 
 #include "data.h"
 
@@ -44,16 +45,65 @@ typedef struct struct_s_PDO_status s_PDO_status;
 #define PDO_INHIBITED 0x01
 #define PDO_RTR_SYNC_READY 0x01
 
+/* State of the compiled TPDO mapping, see buildPDO */
+#define PDO_MAP_STALE   0   /* mapping changed, compiled at the next build */
+#define PDO_MAP_READY   1   /* map holds direct pointers to the mapped variables */
+#define PDO_MAP_GENERIC 2   /* cannot be compiled, decoded through getODentry on each build */
+
+/* Mapped objects a compiled TPDO mapping can hold */
+#define PDO_MAX_MAPPED  8
+
+/** One mapped object of a compiled TPDO mapping */
+typedef struct {
+  UNS8 *pObject;  /* the mapped variable */
+  UNS8 offset;    /* first bit in the frame */
+  UNS8 bits;      /* size in bits */
+  UNS8 bytes;     /* byte count when offset and size are byte aligned, else 0 (bit copy) */
+} s_PDO_map;
+
 /** The PDO structure */
 struct struct_s_PDO_status {
   UNS8 transmit_type_parameter;
   TIMER_HANDLE event_timer;
   TIMER_HANDLE inhibit_timer;
   Message last_message;
+  UNS8 mapState;   /* TPDO only, PDO_MAP_xxx */
+  UNS8 dirty;      /* a mapped object changed since the last build, see PDOMarkDirty */
+  UNS8 mapCount;
+  UNS8 mapLen;     /* frame length of the compiled mapping */
+  s_PDO_map map[PDO_MAX_MAPPED];
 };
 
 #define s_PDO_status_Initializer {0, TIMER_NONE, TIMER_NONE, Message_Initializer}
 
+/* Write flags of a compiled RPDO mapping entry */
+#define RPDO_MAP_ALIGNED 0x01   /* byte aligned in the frame, written straight from it */
+#define RPDO_MAP_RANGE   0x02   /* value range type, checked by valueRangeTest */
+#define RPDO_MAP_SAVE    0x04   /* TO_BE_SAVE, stored after the write */
+
+/** One mapped object of a compiled RPDO mapping */
+typedef struct {
+  UNS8 *pObject;                /* the mapped variable */
+  const indextable *ptrTable;   /* its index, for the callback and storeODSubIndex */
+  ODCallback_t *callbacks;      /* callback list of the index, NULL if it has none */
+  UNS8 bSubindex;
+  UNS8 dataType;
+  UNS8 offset;                  /* first bit in the frame */
+  UNS8 bits;                    /* size in bits */
+  UNS8 size;                    /* size of the variable in bytes */
+  UNS8 flags;                   /* RPDO_MAP_xxx */
+} s_RPDO_map;
+
+/** The receive PDO structure: COB-ID and write plan compiled from 0x1400/0x1600 */
+struct struct_s_RPDO_status {
+  UNS8 mapState;   /* PDO_MAP_xxx */
+  UNS16 cob_id;    /* 0 when the RPDO is not valid */
+  UNS8 mapCount;
+  s_RPDO_map map[PDO_MAX_MAPPED];
+};
+
+#define s_RPDO_status_Initializer {PDO_MAP_STALE, 0, 0}
+
 /** definitions of the different types of PDOs' transmission
  * 
  * SYNCHRO(n) means that the PDO will be transmited every n SYNC signal.
@@ -77,6 +127,10 @@ void PDOInit(CO_Data* d);
 void PDOStop(CO_Data* d);
 void PDOEventTimerAlarm(CO_Data* d, UNS32 pdoNum);
 void PDOInhibitTimerAlarm(CO_Data* d, UNS32 pdoNum);
+UNS32 TPDO_Mapping_Parameter_Callback(CO_Data* d, const indextable * OD_entry, UNS8 bSubindex);
+UNS32 RPDO_Mapping_Parameter_Callback(CO_Data* d, const indextable * OD_entry, UNS8 bSubindex);
+void PDOMarkDirty(CO_Data* d, const void *pObject);
+void PDOMarkDirtyRange(CO_Data* d, const void *pObject, UNS8 size);
 void CopyBits(UNS8 NbBits, UNS8* SrcByteIndex, UNS8 SrcBitIndex, UNS8 SrcBigEndian, UNS8* DestByteIndex, UNS8 DestBitIndex, UNS8 DestBigEndian);
 void sendPdo(CO_Data * d, UNS32 pdoNum, Message * pdo);
 
@@ -61,7 +61,9 @@ struct struct_s_transfer
                               * WARNING s_transfer.data is subject to ENDIANISATION
                               * (with respect to CANOPEN_BIG_ENDIAN)
                               */
-  UNS8           data [SDO_MAX_LENGTH_TRANSFERT];
+  UNS8          *data;       /**< SDO_MAX_LENGTH_TRANSFERT bytes taken from the sdoBuffers pool
+                              * when first needed, NULL if none. Released by resetSDOline.
+                              */
   UNS8           dataType;   /**< Defined in objdictdef.h Value is visible_string
                               * if it is a string, any other value if it is not a string,
                               * like 0. In fact, it is used only if client.
@@ -73,7 +75,15 @@ struct struct_s_transfer
                               * when the response SDO have been received.
                               */
   SDOCallback_t Callback;   /**< The user callback func to be called at SDO transaction end */
-  
+  UNS8           blksize;    /**< Block transfer : number of segments per sub-block */
+  UNS8           seqno;      /**< Block transfer : last segment sent, or received in sequence */
+  UNS8           crcOn;      /**< Block transfer : the client asked for the CRC */
+  UNS32          blockStart; /**< Block upload : offset of the first segment of the sub-block */
+  UNS16          crc;        /**< Block transfer : CRC of the first crcCount bytes */
+  UNS32          crcCount;
+  UNS8           holding;    /**< Block download : a segment is held in held[] */
+  UNS8           held[7];    /**< Block download : last segment received, its padding is only known at the end */
+  const ODStream *stream;    /**< Server : domain streamed in place of data[], NULL if none */
 };
 typedef struct struct_s_transfer s_transfer;
 
@@ -113,6 +123,8 @@ UNS8 setSDOlineRestBytes (CO_Data* d, UNS8 line, UNS32 nbBytes);
 UNS8 sendSDO (CO_Data* d, UNS8 whoami, s_SDO sdo);
 UNS8 sendSDOabort (CO_Data* d, UNS8 whoami, UNS8 nodeId, UNS16 index, UNS8 subIndex, UNS32 abortCode);
 UNS8 processSDO (CO_Data* d, Message *m);
+void sendSDOblockPending (CO_Data* d);
+UNS32 SDO_Server_Parameter_Callback (CO_Data* d, const indextable *OD_entry, UNS8 bSubindex);
 UNS8 writeNetworkDict (CO_Data* d, UNS8 nodeId, UNS16 index,
 		       UNS8 subIndex, UNS32 count, UNS8 dataType, void *data);
 UNS8 writeNetworkDictCallBack (CO_Data* d, UNS8 nodeId, UNS16 index,
@@ -38,9 +38,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /* --------- types and constants definitions --------- */
 #define TIMER_FREE 0        // timer is available for use
-#define TIMER_ARMED 1       // row is active
-#define TIMER_TRIG 2        // timer has been triggered
+#define TIMER_ARMED 1       // row is active, val is its absolute deadline
+#define TIMER_TRIG 2        // one-shot timer in its callback
 #define TIMER_TRIG_PERIOD 3
+#define TIMER_PENDING 4     // expired, callback waits for TimerDispatchPending (or'ed with the above)
 
 #define TIMER_NONE -1
 
@@ -56,6 +57,8 @@ struct struct_s_timer_entry {
 	UNS32 id; /*!< The callback func. */
 	TIMEVAL val;  /*!< this is the current timer value */
 	TIMEVAL interval; /*!< Periodicity */
+	TIMER_HANDLE heapPos; /*!< position in the deadline heap while armed */
+	TIMEVAL due; /*!< deadline that expired, for the dispatch lag */
 };
 
 typedef struct struct_s_timer_entry s_timer_entry;
@@ -67,6 +70,10 @@ extern unsigned char osc_value;
 TIMER_HANDLE SetAlarm(CO_Data* d, UNS32 id, TimerCallback_t callback, TIMEVAL value, TIMEVAL period);
 TIMER_HANDLE DelAlarm(TIMER_HANDLE handle);
 void TimeDispatch(void);
+void TimerDispatchPending(void);
+UNS8 TimerPending(void);
+TIMEVAL TimerGetTime(void);
+UNS8 SetAlarmIsrCallback(TimerCallback_t callback);
 
 //for timer_AVR.c
 void setTimer(TIMEVAL value);
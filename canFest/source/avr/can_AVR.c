@@ -38,11 +38,37 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "scheduler.h"
 
 
+// -- definitions --
+#if (CAN_RX_BUFFER_SIZE & (CAN_RX_BUFFER_SIZE - 1)) || (CAN_RX_BUFFER_SIZE > 128)
+#error CAN_RX_BUFFER_SIZE must be a power of 2, no larger than 128
+#endif
+#define CAN_RX_BUFFER_MSK               (CAN_RX_BUFFER_SIZE - 1)
+#define CAN_BASELINE_TQ                 10      // quanta per bit of the 3/3/3 timing the bus uses
+
+typedef struct {
+  Message m;
+  UNS16 timeStamp;      // TCNT3 when the frame was taken from its MOb
+} s_rx_frame;
+
+typedef struct {
+  Message m;
+  UNS16 timeStamp;      // TCNT3 when the frame was queued
+} s_tx_frame;
+
 // -- prototypes --
 //unsigned char protCanSend(CAN_PORT notused, Message *m);
+static void canLoadTxMob(Message *m);
+static unsigned char canQueueTx(Message *m);
+static unsigned char canSetBitTiming(unsigned int bitrate, unsigned char write);
+static unsigned int canParseBaudRate(char* baud);
 
 // -- data ---
-volatile unsigned char msg_received = 0;
+volatile unsigned char msg_received = 0;  // frames waiting in the rx ring buffer
+static s_rx_frame rxBuffer[CAN_RX_BUFFER_SIZE];
+static volatile UNS8 rxHead = 0;          // written by the isr only
+static volatile UNS8 rxTail = 0;          // written by canReceive only
+static s_tx_frame txQueue[CAN_TX_QUEUE_SIZE]; // frames waiting for a tx MOb, lowest priority (highest cob id) first
+static volatile UNS8 txCount = 0;
 
 volatile UNS16 BitErrors = 0 ;
 volatile UNS16 StuffErrors = 0;
@@ -50,6 +76,11 @@ volatile UNS16 FormErrors = 0;
 volatile UNS16 OtherErrors = 0;
 volatile UNS16 receivedMessages = 0;
 volatile UNS8 syncPulse = 0;
+volatile UNS16 canRxTimeStamp = 0;   // TCNT3 at the last frame received, used to measure wake latency
+UNS16 canReceiveTimeStamp = 0;       // TCNT3 at reception of the frame last returned by canReceive()
+volatile UNS32 canSyncTimeStamp = 0; // CAN timer (8us ticks, overflow extended) at the end of the last SYNC frame
+static volatile UNS8 syncStamped = 0;  // SYNC time stamps not yet processed by UpdateSyncStatistics()
+static volatile UNS16 canTimerOverflows = 0; // upper 16 bits of the CAN timer
 
 
 
@@ -70,6 +101,8 @@ volatile UNS8 syncPulse = 0;
  *  
  *   NNPS CAN clock = 1MHz (tq = 1/CAN clock)
  *    bit rate = CAN clock / tq per bit = 100 kbit
+ *   The segments are computed for any bit rate by canSetBitTiming.  At 100 kbit they are, 
+ *   at every FOSC (BRP 1 at FOSC 1000, 8 at FOSC 8000):
  *
  *   all values are added to 1 by hardware
  *   Synchronization segment              = 1 tq (set in hardware)
@@ -88,28 +121,7 @@ volatile UNS8 syncPulse = 0;
  */
 unsigned char canInit(unsigned int bitrate)
 {
-  unsigned char i,k,j;
-  UNS32 PDOData[4];
-  UNS8 type = 0;
-  UNS32 size = 0;
-  UNS32 * pdata;
-  
-  UNS16 mask0 = 0xFFFF;
-  UNS16 mask1 = 0x000F;
-  
-  for ( j = 0; j < 4; j++)
-  {
-    getODentry( &ObjDict_Data,
-                   0x1400 + j,
-                   1,
-                   pdata,
-                   &size,
-                   &type,
-                   0);
-    PDOData[j] = *pdata;
-  }
-  UNS16 identifiers[] = { 0x0080, (UNS16)getNodeId(&ObjDict_Data), (UNS16)PDOData[0], (UNS16)PDOData[1], (UNS16)PDOData[2], (UNS16)PDOData[3], \
-    0x0000, 0x0140, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 };
+  unsigned char i,k;
   
     //- Pull-up on TxCAN & RxCAN one by one to use bit-addressing
   CAN_PORT_DIR &= ~(1<<CAN_INPUT_PIN );
@@ -118,63 +130,29 @@ unsigned char canInit(unsigned int bitrate)
   CAN_PORT_OUT |=  (1<<CAN_OUTPUT_PIN);
   
   Can_reset();				// Reset the CAN controller
+  rxHead = rxTail = 0;
+  msg_received = 0;
+  txCount = 0;
+  syncStamped = 0;
+  canTimerOverflows = 0;
+  CANTCON = CAN_TIMER_PRESCALE;		// CAN timer time stamps the received frames
   
-  if (bitrate <= 500)
-  {
-
-    #if (FOSC == 8000)
-          CANBT1 = 0x0E;
-          CANBT2 = ((3-1) << SJW) |((3-1) << PRS);	// set SJW, PRS
-          CANBT3 = (((3-1) << PHS2) | ((3-1) << PHS1) | (1<<SMP)); // set PHS1, PHS2, 3 samples
-    #endif
-    #if (FOSC == 4000)
-          CANBT1 = 0x06;
-          CANBT2 = ((3-1) << SJW) |((3-1) << PRS);	// set SJW, PRS
-          CANBT3 = (((3-1) << PHS2) | ((3-1) << PHS1) | (1<<SMP)); // set PHS1, PHS2, 3 samples
-    #endif
-    #if (FOSC == 2000)
-          CANBT1 = 0x02;
-          CANBT2 = ((3-1) << SJW) |((3-1) << PRS);	// set SJW, PRS
-          CANBT3 = (((3-1) << PHS2) | ((3-1) << PHS1) | (1<<SMP)); // set PHS1, PHS2, 3 samples
-    #endif
-    #if (FOSC == 1000)
-          CANBT1 = 0x00;
-          CANBT2 = ((3-1) << SJW) |((3-1) << PRS);	// set SJW, PRS
-          CANBT3 = (((3-1) << PHS2) | ((3-1) << PHS1) | (0<<SMP)); // set PHS1, PHS2, only 1 sample possible due to AVR constraints
-    #endif
- 
-  }
-  else 
+  if (!canSetBitTiming(bitrate, 1))	// set BRP, PRS, PHS1, PHS2, SJW for the bit rate
     return 0;
   
-  // Reset all mailsboxes (MObs), filters are zero (accept all) by clear all MOb
-  // Set the lower MObs as rx buffer
+  // Reset all mailsboxes (MObs)
   for (i = 0; i < NB_MOB; i++)
   {
     Can_set_mob(i);		// Change to MOb with the received message
     Can_clear_mob();		// All MOb Registers=0
     for (k = 0; k < NB_DATA_MAX; k++)
       CANMSG = 0;		// MOb data FIFO
-    if (i < NB_RX_MOB)		// Is receive MOb
-    {
-      Can_config_rx_buffer();	// configure as receive buffer
-      if (i == 1)
-      {
-        Can_set_std_msk(mask1);       // set mask for this mailbox to 0xFFFF (compare everything)
-      }
-      else
-      {
-        Can_set_std_msk(mask0);
-      }
-      
-      Can_set_std_id(identifiers[i]); 
-      
-    }
-    
   }
+  // Set the lower MObs as rx buffers, filtered by the plan built from the OD
+  canSetRxFilters(&ObjDict_Data);
   // The tx MOb is still disabled, it will be set to tx mode when the first message will be sent
   // Enable the general CAN interrupts
-  CANGIE = (1 << ENIT) | (1 << ENRX) | (1 << ENTX) | (0 << ENERR) | (0 << ENERG) | (0 << ENOVRT);
+  CANGIE = (1 << ENIT) | (1 << ENRX) | (1 << ENTX) | (0 << ENERR) | (0 << ENERG) | (1 << ENOVRT);
   CANIE1 = 0x7F;	// Enable the interrupts of all MObs (0..14)
   CANIE2 = 0xFF;   
   Can_enable();                                 // Enable the CAN bus controller
@@ -182,7 +160,155 @@ unsigned char canInit(unsigned int bitrate)
 }
 
 /**
- * @brief Initialize the hardware to receive CAN messages and set up filters based on OD settings
+ * @brief Programs the rx MObs with an acceptance filter plan built from the OD.  SYNC gets its
+ * own MOb (CAN_SYNC_MOB, the lowest number, so it is served first), followed by NMT, this node's 
+ * SDO server and RPDO COB-IDs, node guarding, the boot query and LSS.  Spare MObs buffer extra 
+ * SDO frames.  Every filter compares the full 11 bit id and rejects extended frames, so frames
+ * for other nodes are dropped by the controller without interrupting the CPU.
+ * @details Called from canInit and again when a RPDO COB-ID (0x1400 + n, subindex 1) or a server
+ * SDO COB-ID (0x1200 + n, subindex 1) is written.
+ * @param *d Pointer to the CAN data structure
+ */
+void canSetRxFilters(CO_Data* d)
+{
+  UNS16 filters[NB_RX_MOB];
+  UNS8 n = 0, firstSdo, nSdo, i;
+  UNS16 offset, lastIndex;
+  UNS32 cobId;
+  
+  filters[n++] = 0x080;				// SYNC, must be CAN_SYNC_MOB
+  filters[n++] = 0x000;				// NMT
+  
+  firstSdo = n;
+  offset = d->firstIndex->SDO_SVR;
+  lastIndex = d->lastIndex->SDO_SVR;
+  if (offset)
+    while (offset <= lastIndex && n < NB_RX_MOB)	// SDO client -> server
+    {
+      cobId = *(UNS32 *)d->objdict[offset].pSubindex[1].pObject;
+      if (!(cobId & 0x80000000))			// server in use
+        filters[n++] = (UNS16)cobId & 0x7FF;
+      offset++;
+    }
+  nSdo = n - firstSdo;
+  
+  offset = d->firstIndex->PDO_RCV;
+  lastIndex = d->lastIndex->PDO_RCV;
+  if (offset)
+    while (offset <= lastIndex && n < NB_RX_MOB)	// RPDOs that are valid and configured
+    {
+      cobId = *(UNS32 *)d->objdict[offset].pSubindex[1].pObject;
+      if (!(cobId & 0x80000000) && (cobId & 0x7FF))
+        filters[n++] = (UNS16)cobId & 0x7FF;
+      offset++;
+    }
+  
+  if (n < NB_RX_MOB)
+    filters[n++] = 0x700 + getNodeId(d);	// node guarding request
+  if (n < NB_RX_MOB)
+    filters[n++] = 0x140;			// boot query, see processBOOT
+#ifdef CO_ENABLE_LSS
+  if (n < NB_RX_MOB)
+    filters[n++] = MLSS_ADRESS;
+#endif
+  
+  for (i = 0; nSdo && n < NB_RX_MOB; i++)	// spare MObs take SDO bursts
+    filters[n++] = filters[firstSdo + i % nSdo];
+  
+  cli(); //JML:DISABLE INTERRUPTS
+  for (i = 0; i < NB_RX_MOB; i++)
+  {
+    Can_set_mob(i);
+    CANCDMOB = 0;				// disable the MOb while its filter changes
+    Can_clear_status_mob();
+    if (i < n)
+    {
+      Can_set_std_id(filters[i]);
+      Can_set_std_msk(0x7FF);			// compare every id bit
+      Can_clear_rtr();
+      Can_clear_rtrmsk();
+      Can_set_idemsk();				// standard frames only
+      Can_config_rx_buffer();
+    }
+  }
+  sei(); //JML:RE-ENABLE INTERRUPTS
+}
+
+/**
+ * @brief Reads the free running CAN timer (8us ticks), the time base of canSyncTimeStamp
+ * @return low 16 bits of the CAN timer
+ */
+UNS16 canTimerNow(void)
+{
+  UNS16 t;
+  
+  t = CANTIML;
+  t |= (UNS16)CANTIMH << 8;
+  return t;
+}
+
+/**
+ * @brief Folds the SYNC time stamps taken by the rx isr into the SYNC statistics at 0x2015.
+ * The reference period is SyncStat_ExpectedPeriod, or the running average when that is 0.
+ * A period longer than the reference plus SyncStat_LateMargin counts as late, and every
+ * whole reference period beyond the first counts as a missing SYNC.  Missing SYNCs are
+ * kept out of the average and jitter.  Times are in us.
+ */
+void UpdateSyncStatistics(void)
+{
+  static UNS32 lastStamp;
+  static UNS8 havePrevious = 0;
+  UNS32 stamp, period, ref, dev;
+  UNS8 pending;
+  
+  cli(); //JML:DISABLE INTERRUPTS
+  pending = syncStamped;
+  syncStamped = 0;
+  stamp = canSyncTimeStamp;
+  sei(); //JML:RE-ENABLE INTERRUPTS
+  
+  if (!pending)
+    return;
+  
+  SyncStat_Count += pending;
+  if (pending > 1)              // main loop fell behind, the skipped periods are unknown
+    havePrevious = 0;
+  
+  if (havePrevious)
+  {
+    period = (stamp - lastStamp) * CAN_TIMER_TICK_US;
+    SyncStat_Period = period;
+    if (period < SyncStat_MinPeriod || SyncStat_MinPeriod == 0)
+      SyncStat_MinPeriod = period;
+    if (period > SyncStat_MaxPeriod)
+      SyncStat_MaxPeriod = period;
+    
+    ref = SyncStat_ExpectedPeriod ? SyncStat_ExpectedPeriod : SyncStat_AveragePeriod;
+    if (ref == 0)
+      SyncStat_AveragePeriod = period;        // first period seeds the average
+    else if (period > ref + ref / 2)
+    {
+      SyncStat_MissingCount += (UNS16)((period + ref / 2) / ref - 1);
+    }
+    else
+    {
+      if (period > ref + SyncStat_LateMargin)
+        SyncStat_LateCount++;
+      
+      dev = (period > ref) ? period - ref : ref - period;
+      if (dev > SyncStat_MaxJitter)
+        SyncStat_MaxJitter = dev;
+      // running averages, 1/16 weight for the new sample
+      SyncStat_Jitter = SyncStat_Jitter - (SyncStat_Jitter >> 4) + (dev >> 4);
+      SyncStat_AveragePeriod = SyncStat_AveragePeriod - (SyncStat_AveragePeriod >> 4) + (period >> 4);
+    }
+  }
+  lastStamp = stamp;
+  havePrevious = 1;
+}
+
+/**
+ * @brief Copies the CAN controller error counters to the OD
  */
 void UpdateCANerrors(void)
 {
@@ -222,106 +348,248 @@ void UpdateCANerrors(void)
 
 
 /**
- * @brief The driver send a CAN message passed from the CANopen stack
+ * @brief The driver send a CAN message passed from the CANopen stack.  If no tx MOb is free
+ * the frame is queued by priority (cob id, as in bus arbitration) and sent from the tx 
+ * interrupt when a MOb completes.
  * @param notused (only 1 avaiable)
  * @param *m pointer to message to send
- * @return 1 if  hardware -> CAN frame
+ * @return 1 if  hardware -> CAN frame or queued, 0 if dropped
  */
 unsigned char canSend(CAN_PORT notused, Message *m)
 {
   unsigned char i;
+  unsigned char status;
   
   cli(); //JML:DISABLE INTERRUPTS
-  for (i = START_TX_MOB; i < NB_MOB; i++)	// Search the first free MOb
+  if (txCount == 0)			// a queued frame means every tx MOb is busy
   {
-    Can_set_mob(i);			// Change to MOb
-    if ((CANCDMOB & CONMOB_MSK) == 0)	// MOb disabled = free
+    for (i = START_TX_MOB; i < NB_MOB; i++)	// Search the first free MOb
     {
-      break;
+      Can_set_mob(i);			// Change to MOb
+      if ((CANCDMOB & CONMOB_MSK) == 0)	// MOb disabled = free
+      {
+        break;
+      }
     }
-  }
   
-  if (i < NB_MOB)			// free MOb found
-  {
-    Can_set_mob(i);			// Switch to the sending messagebox
-    Can_set_std_id(m->cob_id);		// Set cob id
-    if (m->rtr)				// Set remote transmission request
-      Can_set_rtr();
-    Can_set_dlc(m->len);		// Set data lenght code
-
-    for (i= 0; i < (m->len); i++)	// Add data bytes to the MOb
-      CANMSG = m->data[i];
-  // Start sending by writing the MB configuration register to transmit
-    Can_config_tx();		// Set the last MOb to transmit mode
-    sei(); //JML:RE-ENABLE INTERRUPTS
-    return 1;	// succesful
+    if (i < NB_MOB)			// free MOb found
+    {
+      canLoadTxMob(m);
+      sei(); //JML:RE-ENABLE INTERRUPTS
+      return 1;	// succesful
+    }
   }
+  
+  status = canQueueTx(m);
+  sei();  //JML:RE-ENABLE INTERRUPTS
+  return status;
+}
+
+/**
+ * @brief Loads a frame into the selected MOb and starts its transmission
+ * @param *m pointer to message to send
+ */
+static void canLoadTxMob(Message *m)
+{
+  unsigned char i;
+  
+  Can_set_std_id(m->cob_id);		// Set cob id
+  if (m->rtr)				// Set remote transmission request
+    Can_set_rtr();
   else
+    Can_clear_rtr();
+  Can_set_dlc(m->len);		// Set data lenght code
+
+  for (i= 0; i < (m->len); i++)	// Add data bytes to the MOb
+    CANMSG = m->data[i];
+  // Start sending by writing the MB configuration register to transmit
+  Can_config_tx();		// Set the last MOb to transmit mode
+}
+
+/**
+ * @brief Inserts a frame in the tx queue, behind queued frames of higher or equal priority.
+ * When the queue is full the lowest priority frame is dropped.  Interrupts must be disabled.
+ * @param *m pointer to message to send
+ * @return 1 if queued, 0 if m was the frame dropped
+ */
+static unsigned char canQueueTx(Message *m)
+{
+  unsigned char i;
+  
+  if (txCount == CAN_TX_QUEUE_SIZE)
   {
-    sei();  //JML:RE-ENABLE INTERRUPTS
-    return 0;	// not succesful
+    CAN_TxQueueDrops++;
+    if (m->cob_id >= txQueue[0].m.cob_id)
+      return 0;
+    for (i = 1; i < txCount; i++)	// drop the lowest priority frame
+      txQueue[i-1] = txQueue[i];
+    txCount--;
   }
+  
+  for (i = txCount; i > 0 && txQueue[i-1].m.cob_id <= m->cob_id; i--)
+    txQueue[i] = txQueue[i-1];
+  txQueue[i].m = *m;
+  txQueue[i].timeStamp = TCNT3;
+  
+  if (++txCount > CAN_TxQueueHighWater)
+    CAN_TxQueueHighWater = txCount;
+  return 1;
 }
 
 /**
- * @brief The driver passes a received CAN message to the stack
+ * @brief The driver passes a received CAN message to the stack.  Frames are copied out
+ * of the MObs by CANIT_interrupt, so this only pops the oldest frame of the rx ring buffer.
  * @param *m pointer to received CAN message
  * @return 1 if a message received
  */
 unsigned char canReceive(Message *m)
 
 {
-  unsigned char i;
-  
+  s_rx_frame *f;
 
-  if (msg_received == 0) // check the stack for a received message (note this is a counter)
+  if (msg_received == 0) // check the ring buffer for a received message (note this is a counter)
     return 0;		// Nothing received
 
+  f = &rxBuffer[rxTail];
+  *m = f->m;
+  canReceiveTimeStamp = f->timeStamp;
+  
   cli();  //JML:DISABLE INTERRUPTS
-  CAN_Receive_Messages++;         
+  rxTail = (rxTail + 1) & CAN_RX_BUFFER_MSK;
+  msg_received--;
+  CAN_Receive_Messages++;         // diagnostic counter
+  sei();  //JML:RE-ENABLE INTERRUPTS
   
+  return 1;                  		// message received
+}
+
+/**
+ * @brief Derives the bit timing for a bit rate from FOSC and optionally writes CANBT1..3
+ * @details The prescaler (BRP) giving the 10 quanta per bit the bus has always used is 
+ *   preferred, so the segments stay 3/3/3 at any FOSC that allows it.  Otherwise the smallest
+ *   BRP giving a whole number of 8..25 quanta per bit is used, so each bit has the most quanta
+ *   available.  PHS2 takes about 30% of the bit (sample point near 70%) and the rest of
+ *   the bit after SYNC is shared between PRS and PHS1.  SJW is the largest allowed, min(4, PHS1, PHS2).  Three samples are only taken
+ *   when the CAN clock is prescaled (AVR constraint).
+ *   At FOSC 1000 the fastest rate is 125 kbit, 1 Mbit needs FOSC 8000.
+ * @param bitrate (in kilobit)
+ * @param write 0 only checks that the bit rate can be reached
+ * @return 1 if the bit rate can be reached exactly at FOSC, 0 otherwise
+ */
+static unsigned char canSetBitTiming(unsigned int bitrate, unsigned char write)
+{
+  UNS8 brp, prs, phs1, phs2, sjw, rest;
+  UNS16 tq;
   
-  for (i = 0; i < NB_RX_MOB; i++)	// Search the first MOb received
+  if (bitrate == 0)
+    return 0;
+  
+  brp = 1;
+  tq = 0;
+  if ((UNS32)FOSC % ((UNS32)CAN_BASELINE_TQ * bitrate) == 0 &&
+      (UNS32)FOSC / ((UNS32)CAN_BASELINE_TQ * bitrate) <= 64)
   {
-    Can_set_mob(i);			// Change to MOb
-    if ((CANCDMOB & CONMOB_MSK) == 0)	// MOb disabled = received
-    {
-      msg_received--;
+    brp = (UNS8)((UNS32)FOSC / ((UNS32)CAN_BASELINE_TQ * bitrate));
+    tq = CAN_BASELINE_TQ;
+  }
+  else for (brp = 1; brp <= 64; brp++)
+  {
+    if ((UNS32)FOSC % ((UNS32)brp * bitrate))
+      continue;			// no whole number of quanta per bit
+    tq = (UNS16)((UNS32)FOSC / ((UNS32)brp * bitrate));
+    if (tq < 8)
+      return 0;			// bit rate too high for FOSC
+    if (tq <= 25)
       break;
-    }
   }
+  if (brp > 64)
+    return 0;
   
-  
-  if (i < NB_RX_MOB)			// message found
-  { 
-    Can_get_std_id(m->cob_id);		// Get cob id
-    m->rtr = Can_get_rtr();		// Get remote transmission request
-    m->len = Can_get_dlc();		// Get data length code
-    for (i= 0; i < (m->len); i++)	// get data bytes from the MOb
-      m->data[i] = CANMSG;
-    Can_config_rx_buffer();		// reset the MOb for receive
-                    // diagnostic counter
-    sei();  //JML:RE-ENABLE INTERRUPTS
-    return 1;                  		// message received
+  phs2 = (tq * 3 + 5) / 10;
+  if (phs2 < 2)
+    phs2 = 2;
+  rest = tq - 1 - phs2;		// quanta for PRS + PHS1
+  if (rest > 16)		// PRS and PHS1 are at most 8 each
+  {
+    phs2 += rest - 16;
+    rest = 16;
   }
-  else					// no message found
+  phs1 = rest / 2;
+  prs = rest - phs1;
+  sjw = (phs1 < phs2) ? phs1 : phs2;
+  if (sjw > 4)
+    sjw = 4;
+  
+  if (write)
   {
-    msg_received = 0;			// reset counter
-    sei(); //JML:RE-ENABLE INTERRUPTS
-    return 0;                  		// no message received
+    CANBT1 = (brp - 1) << 1;						// BRP starts at bit 1
+    CANBT2 = ((sjw - 1) << SJW) | ((prs - 1) << PRS);			// set SJW, PRS
+    CANBT3 = ((phs2 - 1) << PHS2) | ((phs1 - 1) << PHS1) | ((brp > 1) << SMP);	// set PHS1, PHS2, samples
   }
+  return 1;
+}
+
+/**
+ * @brief Converts a CanFestival bit rate string ("1M", "500K", "125K", ...) to kilobit
+ * @param baud bit rate string
+ * @return bit rate in kilobit, 0 if the string is not understood
+ */
+static unsigned int canParseBaudRate(char* baud)
+{
+  unsigned int rate = 0;
+  
+  while (*baud >= '0' && *baud <= '9')
+    rate = rate * 10 + (*baud++ - '0');
+  if (*baud == 'M')
+    rate *= 1000;
+  else if (*baud != 'K')
+    rate = 0;
+  return rate;
+}
+
+/**
+ * @brief Checks if the driver can run the bus at a bit rate, used by the LSS slave 
+ *   before accepting a Configure Bit Timing request
+ * @param baud bit rate string ("1M", "500K", ...)
+ * @return 1 if supported at FOSC
+ */
+UNS8 canBaudRateSupported(char* baud)
+{
+  return canSetBitTiming(canParseBaudRate(baud), 0);
 }
 
 /**
- * @brief
- * @param fd
- * @param baud
- * @return always 0
+ * @brief Switches the bus to a new bit rate.  The controller goes off the bus at the end 
+ *   of the frame in progress, the bit timing is reprogrammed, and it rejoins the bus.
+ *   MOb filters and queued frames are kept.
+ * @param fd not used
+ * @param baud bit rate string ("1M", "500K", "250K", "125K", ...)
+ * @return 0 if the bit rate was changed, 1 if it is not supported
  */
 unsigned char canChangeBaudRate_driver( CAN_HANDLE fd, char* baud)
 {
+  unsigned int bitrate = canParseBaudRate(baud);
+  
+  if (!canSetBitTiming(bitrate, 0))
+    return 1;
+  
+  Can_disable();
+  while (CANGSTA & (1 << ENFG))	// wait for the controller to leave the bus
+    ;
+  canSetBitTiming(bitrate, 1);
+  Can_enable();
+  return 0;
+}
 
-	return 0;
+/**
+ * @brief CanFestival entry point for bit rate changes (LSS Activate Bit Timing)
+ * @param port not used
+ * @param baud bit rate string
+ * @return 0 if the bit rate was changed
+ */
+UNS8 canChangeBaudRate(CAN_PORT port, char* baud)
+{
+  return canChangeBaudRate_driver(port, baud);
 }
 
 
@@ -333,7 +601,9 @@ unsigned char canChangeBaudRate_driver( CAN_HANDLE fd, char* baud)
  */
 void CANIT_interrupt(void)
 {
-  unsigned char i;
+  unsigned char i, k, len;
+  UNS16 stamp, overflows;
+  UNS8 command[NB_DATA_MAX];
   
   if (CANGIT & (1 << CANIT))	// is a messagebox interrupt
   {
@@ -346,15 +616,52 @@ void CANIT_interrupt(void)
           if (CANSTMOB & MOB_RX_COMPLETED)	// receive ok
           {
             
-            Can_clear_status_mob();	    // Clear status register
-            Can_mob_abort();		    // disable the MOb = received
-            if ( CANIDT1 == 0x10 )          // check for sync pulse (0x80)
-            {                               // note that cobID is made up of CANIDT1 and CANIDT2
+            canRxTimeStamp = TCNT3;
+            if ( i == CAN_SYNC_MOB )        // sync pulse (0x80) has its own MOb
+            {
+              stamp = CANSTML;              // CAN timer latched by the controller at end of frame
+              stamp |= (UNS16)CANSTMH << 8;
+              overflows = canTimerOverflows;
+              if ((CANGIT & (1 << OVRTIM)) && !(stamp & 0x8000))
+                overflows++;                // timer wrapped, overflow isr still pending
+              canSyncTimeStamp = ((UNS32)overflows << 16) | stamp;
+              syncStamped++;
+              
+              len = Can_get_dlc();          // command bytes for this period
+              if (len > NB_DATA_MAX)        // DLC 9..15 is legal and still carries 8 bytes
+                len = NB_DATA_MAX;
+              for (k = 0; k < len; k++)
+                command[k] = CANMSG;
+              Can_set_mob(i);               // rewind the MOb data index for the copy below
+              SyncLatchCommand(command, len);
               syncPulse = 1;
               //PORTE ^= 0x02; //BIT1 JML Debug
               SyncScheduler();
             }
-            msg_received++;                  // notify message received (including sync pulse)
+            
+            if (msg_received < CAN_RX_BUFFER_SIZE)
+            {
+              s_rx_frame *f = &rxBuffer[rxHead];
+              
+              Can_get_std_id(f->m.cob_id);		// Get cob id
+              f->m.rtr = Can_get_rtr();		// Get remote transmission request
+              f->m.len = Can_get_dlc();		// Get data length code
+              if (f->m.len > NB_DATA_MAX)       // DLC 9..15 means 8 bytes
+                f->m.len = NB_DATA_MAX;
+              for (k = 0; k < f->m.len; k++)	// get data bytes from the MOb
+                f->m.data[k] = CANMSG;
+              f->timeStamp = canRxTimeStamp;
+              
+              rxHead = (rxHead + 1) & CAN_RX_BUFFER_MSK;
+              msg_received++;                  // notify message received (including sync pulse)
+              if (msg_received > CAN_RxQueueHighWater)
+                CAN_RxQueueHighWater = msg_received;
+            }
+            else
+              CAN_RxQueueOverflows++;          // ring buffer full, frame dropped
+            
+            Can_clear_status_mob();	    // Clear status register
+            Can_config_rx_buffer();	    // MOb is free again for the next frame
           }
           else if (CANSTMOB & ~MOB_RX_COMPLETED)	// error
           {
@@ -390,8 +697,21 @@ void CANIT_interrupt(void)
         Can_set_mob(i);			// change to MOb
         if (CANSTMOB)			// transmission ok or error
         {
+          if (CANSTMOB & MOB_TX_COMPLETED)
+            CAN_Transmit_Messages++;	// diagnostic counter
           Can_clear_status_mob();	// clear status register
 	  CANCDMOB = 0;			// disable the MOb
+          
+          if (txCount)			// MOb is free, send the highest priority queued frame
+          {
+            UNS32 latency;
+            
+            txCount--;
+            canLoadTxMob(&txQueue[txCount].m);
+            latency = TIMEVAL_TO_US((UNS16)(TCNT3 - txQueue[txCount].timeStamp)); // tmr3 tick is 8 to 32us with FOSC
+            if (latency > CAN_TxQueueMaxLatency)
+              CAN_TxQueueMaxLatency = latency;
+          }
 	  break;
         }
       }
@@ -423,5 +743,6 @@ ISR(OVRIT_vect)
 
 {
   CANGIT |= (1 << OVRTIM);
+  canTimerOverflows++;
 }
 
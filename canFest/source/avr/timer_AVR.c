@@ -38,8 +38,52 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #define TimerCounter      TCNT3
 
 /************************** Module variables **********************************/
-// Store the last timer value to calculate the elapsed time
-static TIMEVAL last_time_set = 0;//TIMEVAL_MAX;     
+// tmr3 is extended to a 32 bit timebase: overflows counted in the high word
+static volatile unsigned int timerOverflows = 0;
+static TIMEVAL last_time_set = 0;       // time of the last alarm, the timer reference
+static TIMEVAL alarm_time = 0;          // time of the programmed alarm
+static unsigned char alarm_waiting = 0; // alarm more than one tmr3 period away, armed by the overflow isr
+
+/**
+ * @brief Reads the 32 bit timebase.  Called with interrupts disabled (stack lock or isr).
+ * @details An overflow that has not been counted yet shows as TOV3 with a small count.
+ */
+static TIMEVAL timerNow(void)
+{
+  unsigned int high = timerOverflows;
+  unsigned int low = TimerCounter;
+  
+  if ((TIFR3 & (1 << TOV3)) && low < 0x8000)
+    high++;
+  return ((TIMEVAL)high << 16) | low;
+}
+
+/**
+ * @brief Enables the compare interrupt for alarm_time once it is less than one tmr3 
+ *  period away, the next match of OCR3B is then the alarm itself.  An alarm already due,
+ *  or too close to be caught, gets a compare point TIMER_MIN_ALARM ahead of the counter
+ *  instead of waiting for the counter to wrap.
+ */
+static void armCompare(void)
+{
+  INTEGER32 delta = (INTEGER32)(alarm_time - timerNow());
+  
+  if (delta > 0xFFFF)
+  {
+    TIMSK3 &= ~(1 << OCIE3B);
+    alarm_waiting = 1;
+    return;
+  }
+  if (delta < TIMER_MIN_ALARM)
+    TimerAlarm = TimerCounter + TIMER_MIN_ALARM;
+  TIFR3 = 1 << OCF3B;                   // drop a match of the previous compare point
+  TIMSK3 |= 1 << OCIE3B;
+  alarm_waiting = 0;
+  // due now with no match pending: a match between the OCR3B write and the flag clear
+  // was dropped too, compare again ahead of the counter
+  if ((INTEGER32)(timerNow() - alarm_time) >= 0 && !(TIFR3 & (1 << OCF3B)))
+    TimerAlarm = TimerCounter + TIMER_MIN_ALARM;
+}
 
 /**
  * @brief Initializes the timer, turn on the interrupt and put the interrupt time to zero
@@ -51,38 +95,47 @@ void initTimer(void)
 	// Set timer 3 for CANopen operation tick 8us, rollover time is  524ms at 8 MHz
         //                                       16us, rollover time is 1048ms at 4 MHz 
         //                                       32us, rollover time is 2096ms at 2 MHz
-        //                                       64us, rollover time is 4192ms at 1 MHz 
+        //                                        8us, rollover time is  524ms at 1 MHz 
   #if (FOSC == 1000)
     TCCR3B = 1 << CS31;       // Timer 3 normal, with CKio/8
-  #elif
+  #else
     TCCR3B = 1 << CS31 | 1 << CS30;       // Timer 3 normal, with CKio/64
   #endif
 
-  TIMSK3 = 1 << OCIE3B;                 // Enable the interrupt
+  TIMSK3 = 1 << TOIE3;                  // Count the roll overs, the compare is enabled by setTimer
 }
 
 /**
  * @brief Set the timer for the next alarm.
- * @param value TIMEVAL (unsigned long)
+ * @param value TIMEVAL (unsigned long) ticks after the reference, the last alarm
  */
 void setTimer(TIMEVAL value)
 {
-  TimerAlarm += (int)value; // Add the desired time to timer interrupt time
+  alarm_time = last_time_set + value;
+  TimerAlarm = (unsigned int)alarm_time; // Compare point relative to the last alarm
+  armCompare();
 }
 
 /**
  * @brief Return the elapsed time to tell the Stack how much time is spent since last call.
- * @return value TIMEVAL (unsigned long) the elapsed time
+ *        TIMEVAL units are timer 3 ticks at every FOSC (see timerscfg.h), counted on the
+ *        32 bit timebase so any alarm length is measured right.
+ * @return value TIMEVAL (unsigned long) the elapsed time since the last alarm
  */
 TIMEVAL getElapsedTime(void)
 {
-  unsigned int timer = TimerCounter * (8000/FOSC);            // Copy the value of the running timer
-  if (timer > last_time_set)                    // In case the timer value is higher than the last time.
-    return (timer - last_time_set);             // Calculate the time difference
-  else if (timer < last_time_set)
-    return (last_time_set - timer);             // Calculate the time difference
-  else
-    return TIMEVAL_MAX;
+  return timerNow() - last_time_set;
+}
+
+/**
+ * @brief The programmed alarm is reached: the reference moves to it and the stack runs
+ */
+static void timerAlarm(void)
+{
+  TIMSK3 &= ~(1 << OCIE3B);
+  alarm_waiting = 0;
+  last_time_set = alarm_time;           // latency shows as overrun
+  TimeDispatch();                       // Call the time handler of the stack, it programs the next alarm
 }
 
 //============================
@@ -92,13 +145,27 @@ TIMEVAL getElapsedTime(void)
 #pragma type_attribute = __interrupt
 #pragma vector = TIMER3_COMPB_vect
 /**
- * Timer 3 Interrupt, calls TimeDispatch()
+ * Timer 3 Interrupt, calls TimeDispatch(), which only marks most alarms pending for
+ * TimerDispatchPending() in the main loop
  */
 void TIMER3_COMPB_interrupt(void)
 {
-  last_time_set = TimerCounter * (8000/FOSC); 
-  TimeDispatch();                               // Call the time handler of the stack to adapt the elapsed time
+  if ((INTEGER32)(timerNow() - alarm_time) >= 0)  // ignore a match of an older compare point
+    timerAlarm();
 }
 
-
-
+#pragma type_attribute = __interrupt
+#pragma vector = TIMER3_OVF_vect
+/**
+ * Timer 3 overflow Interrupt, extends the timebase and arms a long alarm for its last period
+ */
+void TIMER3_OVF_interrupt(void)
+{
+  timerOverflows++;
+  if (!alarm_waiting)
+    return;
+  if ((INTEGER32)(alarm_time - timerNow()) < TIMER_MIN_ALARM)  // too close to catch by compare
+    timerAlarm();
+  else
+    armCompare();
+}
@@ -44,7 +44,7 @@
 #include "canfestival.h"
 #include "sysdep.h"
 #include "sys.h"
-#include "objdict.h"
+#include "ObjDict.h"
 
 /*Internals prototypes*/
 void ConsumerHearbeatAlarm(CO_Data* d, UNS32 id);
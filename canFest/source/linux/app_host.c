@@ -0,0 +1,149 @@
+/*
+This file is part of CanFestival, a library implementing CanOpen Stack.
+
+Copyright (C): Edouard TISSERANT and Francis DUPIN
+Linux host port for the rmStim node
+
+See COPYING file for copyrights details.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file   app_host.c
+ * @brief Application entry points called by the stack and by ObjDict.c, for the Linux
+ *        host build.  The rmStim application (app/) drives the AVR peripherals and is not
+ *        built on the host: the NMT mode commands only change the state, there is no
+ *        EEPROM (nothing is restored, saves are dropped) and the EEPROM domains are empty.
+ */
+
+#include <stdlib.h>
+
+#include "canfestival.h"
+#include "ObjDict.h"
+#include "eedata.h"
+#include "app.h"
+#include "runcanserver.h"
+#include "stimTask.h"
+#include "scheduler.h"
+
+// -- EEPROM domains (eedata.c) --
+const ODStream PatternArea_Stream = { 0, NULL, NULL };
+const ODStream FlashImage_Stream = { 0, NULL, NULL };
+const ODStream PatternSlot_Stream[MAX_PATTERNS];
+const ODStream PatternHash_Stream = { 0, NULL, NULL };
+ODStream MemWindow_Stream = { 0, NULL, NULL };
+
+UNS32 MemWindow_Update( CO_Data* d, const indextable *unused_indextable, UNS8 unused_bSubindex )
+{
+  return OD_SUCCESSFUL;
+}
+
+UNS32 MemCrc_Start( CO_Data* d, const indextable *unused_indextable, UNS8 unused_bSubindex )
+{
+  return OD_SUCCESSFUL;
+}
+
+void SaveValues( void ) {}
+void RestoreValues( void ) {}
+void EraseEprom( UNS8 space ) {}
+void EEPROM_Flush( void ) {}
+
+/**
+ * @brief The AVR resets through the watchdog, the host node exits
+ */
+void ResetModule( void )
+{
+  exit( 0 );
+}
+
+void ResetToODDefault( void )
+{
+  ResetModule();
+}
+
+// -- patterns and scheduler (stimTask.c, scheduler.c) --
+void UpdateActivePatterns( UNS8 functionGroup, UNS8 write ) {}
+void ClearAllActivePatterns( void ) {}
+void TransferPatternEEPROM( UNS8 patternID, UNS8 write ) {}
+void InitSchedulerOD( void ) {}
+
+// -- app.c, runcanserver.c --
+void processSYNCMessageForApp( Message* m ) {}
+void EnterDeepSleep( void ) {}
+
+UNS8 processBOOT( CO_Data* d, Message *m )
+{
+  return 0;
+}
+
+void StartNodesFunc( CO_Data* d, Message *m )
+{
+  if ( d->nodeState == Hibernate )
+    setState( d, Waiting );
+  else
+    setState( d, Unknown_state );
+}
+
+void StopNodesFunc( CO_Data* d, Message *m )
+{
+  setState( d, Stopped );
+}
+
+void EnterWaitingFunc( CO_Data* d, Message *m )
+{
+  setState( d, Waiting );
+}
+
+void EnterPatientOperationFunc( CO_Data* d, Message *m )
+{
+  if ( d->nodeState == Waiting && m->data[1] == 0 ) //must be NMT broadcast and in waiting
+    setState( d, Mode_Patient_Control );
+}
+
+void EnterXManualFunc( CO_Data* d, Message *m )
+{
+  if ( d->nodeState == Waiting )
+    setState( d, Mode_X_Manual );
+}
+
+void EnterYManualFunc( CO_Data* d, Message *m )
+{
+  if ( d->nodeState == Waiting )
+    setState( d, Mode_Y_Manual );
+}
+
+void EnterStopStimFunc( CO_Data* d, Message *m )
+{
+  setState( d, Stopped );
+}
+
+void EnterPatientManualFunc( CO_Data* d, Message *m )
+{
+  if ( d->nodeState == Waiting && m->data[1] == 0 )
+    setState( d, Mode_Patient_Manual );
+}
+
+void EnterProduceXManualFunc( CO_Data* d, Message *m )
+{
+  if ( d->nodeState == Waiting && m->data[1] == 0 )
+    setState( d, Mode_Produce_X_Manual );
+}
+
+void EnterRecordXFunc( CO_Data* d, Message *m )
+{
+  if ( d->nodeState == Waiting )
+    setState( d, Mode_Record_X );
+}
@@ -0,0 +1,237 @@
+/*
+This file is part of CanFestival, a library implementing CanOpen Stack.
+
+Copyright (C): Edouard TISSERANT and Francis DUPIN
+Linux host port for the rmStim node
+
+See COPYING file for copyrights details.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file   can_socket.c
+ * @brief Linux SocketCAN implementation of the CANopen driver, so the stack and 
+ *        ObjDict.c can run on a host against a real or virtual (vcan) interface.
+ * @details Frames are read without blocking; the host main loop waits on canGetFd() and
+ *   TimerWaitMs(), then drains canReceive() into canDispatch() as RunCANServerTask does.
+ *   Acceptance filters follow the same plan as the AVR MObs (see canSetRxFilters).
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+#include "canfestival.h"
+#include "ObjDict.h"
+
+// -- definitions --
+#define NB_RX_FILTERS   13      // same number of rx filters as the AVR has rx MObs
+
+// -- data ---
+static int canFd = -1;
+
+/**
+ * @brief Opens a raw CAN socket on $CAN_IFNAME (or CAN_IFNAME) and sets the filters
+ * @param bitrate (in kilobit) not used, the interface bit rate is set with "ip link"
+ * @return 1 if successful
+ */
+unsigned char canInit(unsigned int bitrate)
+{
+  struct sockaddr_can addr;
+  struct ifreq ifr;
+  const char *ifname = getenv("CAN_IFNAME");
+  
+  if (ifname == NULL)
+    ifname = CAN_IFNAME;
+  
+  if (canFd >= 0)
+    close(canFd);
+  canFd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (canFd < 0)
+    return 0;
+  
+  memset(&ifr, 0, sizeof(ifr));
+  strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+  if (ioctl(canFd, SIOCGIFINDEX, &ifr) < 0)
+  {
+    MSG_ERR(0x1F01, "CAN interface not found", 0);
+    close(canFd);
+    canFd = -1;
+    return 0;
+  }
+  
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  if (bind(canFd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    close(canFd);
+    canFd = -1;
+    return 0;
+  }
+  fcntl(canFd, F_SETFL, fcntl(canFd, F_GETFL) | O_NONBLOCK);
+  
+  canSetRxFilters(&ObjDict_Data);
+  return 1;
+}
+
+/**
+ * @brief Socket to wait on (poll/select) for received frames
+ * @return file descriptor, -1 before canInit
+ */
+int canGetFd(void)
+{
+  return canFd;
+}
+
+/**
+ * @brief Installs the acceptance filters built from the OD: SYNC, NMT, the SDO server
+ * and RPDO COB-IDs, node guarding, the boot query and LSS.  Standard frames only, as on
+ * the AVR.
+ * @param *d Pointer to the CAN data structure
+ */
+void canSetRxFilters(CO_Data* d)
+{
+  struct can_filter filters[NB_RX_FILTERS];
+  UNS8 n = 0;
+  UNS16 offset, lastIndex;
+  UNS32 cobId;
+  UNS16 id[NB_RX_FILTERS];
+  
+  if (canFd < 0)
+    return;
+  
+  id[n++] = 0x080;                              // SYNC
+  id[n++] = 0x000;                              // NMT
+  
+  offset = d->firstIndex->SDO_SVR;
+  lastIndex = d->lastIndex->SDO_SVR;
+  if (offset)
+    while (offset <= lastIndex && n < NB_RX_FILTERS)    // SDO client -> server
+    {
+      cobId = *(UNS32 *)d->objdict[offset].pSubindex[1].pObject;
+      if (!(cobId & 0x80000000))                // server in use
+        id[n++] = (UNS16)cobId & 0x7FF;
+      offset++;
+    }
+  
+  offset = d->firstIndex->PDO_RCV;
+  lastIndex = d->lastIndex->PDO_RCV;
+  if (offset)
+    while (offset <= lastIndex && n < NB_RX_FILTERS)    // RPDOs that are valid and configured
+    {
+      cobId = *(UNS32 *)d->objdict[offset].pSubindex[1].pObject;
+      if (!(cobId & 0x80000000) && (cobId & 0x7FF))
+        id[n++] = (UNS16)cobId & 0x7FF;
+      offset++;
+    }
+  
+  if (n < NB_RX_FILTERS)
+    id[n++] = 0x700 + getNodeId(d);             // node guarding request
+  if (n < NB_RX_FILTERS)
+    id[n++] = 0x140;                            // boot query, see processBOOT
+#ifdef CO_ENABLE_LSS
+  if (n < NB_RX_FILTERS)
+    id[n++] = MLSS_ADRESS;
+#endif
+  
+  for (offset = 0; offset < n; offset++)
+  {
+    filters[offset].can_id = id[offset];
+    filters[offset].can_mask = CAN_EFF_FLAG | CAN_SFF_MASK;   // all 11 bits, no extended frames
+  }
+  setsockopt(canFd, SOL_CAN_RAW, CAN_RAW_FILTER, filters, n * sizeof(filters[0]));
+}
+
+/**
+ * @brief Sends a CAN message passed from the CANopen stack
+ * @param notused (only 1 avaiable)
+ * @param *m pointer to message to send
+ * @return 1 if written to the socket, 0 if dropped
+ */
+UNS8 canSend(CAN_PORT notused, Message *m)
+{
+  struct can_frame frame;
+  
+  if (canFd < 0)
+    return 0;
+  
+  memset(&frame, 0, sizeof(frame));
+  frame.can_id = m->cob_id & CAN_SFF_MASK;
+  if (m->rtr)
+    frame.can_id |= CAN_RTR_FLAG;
+  frame.can_dlc = m->len;
+  memcpy(frame.data, m->data, m->len);
+  
+  return write(canFd, &frame, sizeof(frame)) == sizeof(frame);
+}
+
+/**
+ * @brief Takes the next received frame from the socket without blocking
+ * @param *m pointer to received CAN message
+ * @return 1 if a message was received, 0 if none is waiting
+ */
+unsigned char canReceive(Message *m)
+{
+  struct can_frame frame;
+  
+  if (canFd < 0)
+    return 0;
+  if (read(canFd, &frame, sizeof(frame)) != sizeof(frame))
+    return 0;                                   // EAGAIN, nothing waiting
+  
+  m->cob_id = frame.can_id & CAN_SFF_MASK;
+  m->rtr = (frame.can_id & CAN_RTR_FLAG) ? 1 : 0;
+  m->len = frame.can_dlc > 8 ? 8 : frame.can_dlc;
+  memcpy(m->data, frame.data, m->len);
+  return 1;
+}
+
+/**
+ * @brief Accepts the CiA bit rates ("1M", "800K", "500K", ... "10K")
+ * @param baud bit rate string
+ * @return 1 if the string names a CiA bit rate
+ */
+UNS8 canBaudRateSupported(char* baud)
+{
+  static const char *rates[] = { "1M", "800K", "500K", "250K", "125K", "100K", "50K", "20K", "10K" };
+  UNS8 i;
+  
+  for (i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+    if (strcmp(baud, rates[i]) == 0)
+      return 1;
+  return 0;
+}
+
+/**
+ * @brief The bit rate of a SocketCAN interface belongs to the kernel ("ip link set canX
+ *   type can bitrate ..."), a vcan has none.  The request is accepted so LSS sequences
+ *   run to completion on the host.
+ * @param port not used
+ * @param baud bit rate string
+ * @return 0
+ */
+UNS8 canChangeBaudRate(CAN_PORT port, char* baud)
+{
+  MSG_WAR(0x3F02, "bit rate change ignored on the host", 0);
+  return 0;
+}
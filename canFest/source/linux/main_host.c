@@ -0,0 +1,66 @@
+/*
+This file is part of CanFestival, a library implementing CanOpen Stack.
+
+Copyright (C): Edouard TISSERANT and Francis DUPIN
+Linux host port for the rmStim node
+
+See COPYING file for copyrights details.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file   main_host.c
+ * @brief Runs the rmStim object dictionary as a CANopen node on a SocketCAN interface
+ *        ($CAN_IFNAME, default vcan0), for testing masters and tools without hardware.
+ *        Usage: rmstim_host [node id]
+ */
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "canfestival.h"
+#include "ObjDict.h"
+
+int main(int argc, char *argv[])
+{
+  struct pollfd pfd;
+  Message m = Message_Initializer;
+
+  if (!canInit(CAN_BAUDRATE))
+  {
+    fprintf(stderr, "rmstim_host: no CAN interface (set CAN_IFNAME)\n");
+    return 1;
+  }
+  initTimer();
+  if (argc > 1)
+    Status_NodeId = (UNS8)atoi(argv[1]);
+  setNodeId(&ObjDict_Data, Status_NodeId);
+  canSetRxFilters(&ObjDict_Data);
+  setState(&ObjDict_Data, Waiting);
+
+  pfd.fd = canGetFd();
+  pfd.events = POLLIN;
+  for (;;)
+  {
+    poll(&pfd, 1, TimerWaitMs());
+    while (canReceive(&m))
+      canDispatch(&ObjDict_Data, &m);
+    TimerPoll();
+    sendSDOblockPending(&ObjDict_Data);
+  }
+  return 0;
+}
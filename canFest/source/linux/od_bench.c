@@ -0,0 +1,96 @@
+/*
+This file is part of CanFestival, a library implementing CanOpen Stack.
+
+Copyright (C): Edouard TISSERANT and Francis DUPIN
+Linux host port for the rmStim node
+
+See COPYING file for copyrights details.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file   od_bench.c
+ * @brief Host benchmark of the object dictionary lookup, ObjDict_scanIndexOD.
+ *        - mapped: indexes that exist, in random order (SDO and PDO accesses)
+ *        - mixed: half of them replaced by random indexes, mostly missing
+ *        - sweep: every index from 0x0000 to 0xFFFF in order
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "canfestival.h"
+#include "ObjDict.h"
+
+#define LOOKUPS         (1L << 16)
+#define ROUNDS          64
+
+static UNS16 mapped[LOOKUPS];
+static UNS16 mixed[LOOKUPS];
+static volatile UNS32 sink;
+
+static UNS32 rnd(void)
+{
+  static UNS32 x = 2463534242UL;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
+
+/**
+ * @brief ns per lookup of the LOOKUPS indexes of list, ROUNDS times
+ */
+static double timeLookups(const UNS16 *list)
+{
+  struct timespec start, end;
+  const indextable *row;
+  ODCallback_t *callbacks;
+  UNS32 errorCode;
+  long i, r;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (r = 0; r < ROUNDS; r++)
+    for (i = 0; i < LOOKUPS; i++)
+    {
+      row = ObjDict_scanIndexOD(list ? list[i] : (UNS16)i, &errorCode, &callbacks);
+      sink += errorCode + (row != NULL);
+    }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / (ROUNDS * LOOKUPS);
+}
+
+int main(void)
+{
+  UNS16 present[256];
+  UNS32 errorCode;
+  ODCallback_t *callbacks;
+  long i, n = 0;
+
+  for (i = 0; i < 0x10000 && n < 256; i++)
+    if (ObjDict_scanIndexOD((UNS16)i, &errorCode, &callbacks))
+      present[n++] = (UNS16)i;
+  for (i = 0; i < LOOKUPS; i++)
+  {
+    mapped[i] = present[rnd() % n];
+    mixed[i] = (rnd() & 1) ? mapped[i] : (UNS16)rnd();
+  }
+
+  printf("%ld indexes  mapped %5.1f ns  mixed %5.1f ns  sweep %5.1f ns per lookup\n",
+         n, timeLookups(mapped), timeLookups(mixed), timeLookups(NULL));
+  return 0;
+}
@@ -0,0 +1,176 @@
+/*
+This file is part of CanFestival, a library implementing CanOpen Stack.
+
+Copyright (C): Edouard TISSERANT and Francis DUPIN
+Linux host port for the rmStim node
+
+See COPYING file for copyrights details.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file   smoke_test.c
+ * @brief Host smoke test: the stack, ObjDict.c and the polled timer, with the frames the
+ *        node sends captured in memory instead of a CAN socket, so it runs without a CAN
+ *        interface.  Checks that the object dictionary is sorted for the bisection lookup,
+ *        an SDO upload, download and abort, and the heartbeat produced from the timer.
+ *        Exit status 0 when every check passes.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "canfestival.h"
+#include "ObjDict.h"
+
+#define NODE_ID         4
+#define SENT_MAX        64
+
+extern UNS16 ObjDict_obj1017;   // producer heartbeat time, not exported by ObjDict.h
+extern const indextable ObjDict_objdict[];
+extern const UNS16 ObjDict_ObjdictSize;
+
+static Message sent[SENT_MAX];
+static int nbSent;
+static int failures;
+
+// -- the CAN driver, in memory --
+UNS8 canSend(CAN_PORT notused, Message *m)
+{
+  if (nbSent < SENT_MAX)
+    sent[nbSent++] = *m;
+  return 0;
+}
+
+void canSetRxFilters(CO_Data* d) {}
+UNS8 canBaudRateSupported(char* baud) { return 1; }
+UNS8 canChangeBaudRate(CAN_PORT port, char* baud) { return 0; }
+
+static void check(int ok, const char *what)
+{
+  printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok)
+    failures++;
+}
+
+/**
+ * @brief Checks that every row of the object dictionary comes after the one before it and
+ *        is found by ObjDict_scanIndexOD, which searches it by bisection
+ */
+static int objdictSorted(void)
+{
+  const indextable *row;
+  ODCallback_t *callbacks;
+  UNS32 errorCode;
+  UNS16 i;
+
+  for (i = 0; i < ObjDict_ObjdictSize; i++)
+  {
+    if (i > 0 && ObjDict_objdict[i].index <= ObjDict_objdict[i - 1].index)
+    {
+      printf("      0x%04X is not after 0x%04X\n", ObjDict_objdict[i].index, ObjDict_objdict[i - 1].index);
+      return 0;
+    }
+    row = ObjDict_scanIndexOD(ObjDict_objdict[i].index, &errorCode, &callbacks);
+    if (row != &ObjDict_objdict[i])
+    {
+      printf("      0x%04X not found\n", ObjDict_objdict[i].index);
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * @brief Dispatches an 8 byte SDO request to the node and returns its answer, NULL if none
+ */
+static const Message *sdoRequest(UNS8 cs, UNS16 index, UNS8 subIndex, UNS32 value)
+{
+  Message m = Message_Initializer;
+  int i;
+
+  m.cob_id = 0x600 + NODE_ID;
+  m.len = 8;
+  m.data[0] = cs;
+  m.data[1] = (UNS8)index;
+  m.data[2] = (UNS8)(index >> 8);
+  m.data[3] = subIndex;
+  for (i = 0; i < 4; i++)
+    m.data[4 + i] = (UNS8)(value >> (8 * i));
+  nbSent = 0;
+  canDispatch(&ObjDict_Data, &m);
+  for (i = 0; i < nbSent; i++)
+    if (sent[i].cob_id == 0x580 + NODE_ID)
+      return &sent[i];
+  return NULL;
+}
+
+/**
+ * @brief Runs the timer for ms milliseconds, as the host main loop does
+ */
+static void runFor(int ms)
+{
+  struct timespec start, now, nap;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  do
+  {
+    int wait = TimerWaitMs();
+
+    if (wait > 5)
+      wait = 5;
+    nap.tv_sec = 0;
+    nap.tv_nsec = wait * 1000000L;
+    nanosleep(&nap, NULL);
+    TimerPoll();
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  } while ((now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000 < ms);
+}
+
+int main(void)
+{
+  const Message *r;
+  int i, heartbeats = 0;
+
+  initTimer();
+  setNodeId(&ObjDict_Data, NODE_ID);
+  setState(&ObjDict_Data, Waiting);
+
+  check(objdictSorted(), "object dictionary sorted by index");
+
+  r = sdoRequest(0x40, 0x1017, 0, 0);  // upload the producer heartbeat time
+  check(r && r->data[0] == 0x4B && r->data[4] + (r->data[5] << 8) == ObjDict_obj1017,
+        "SDO expedited upload of 0x1017");
+
+  r = sdoRequest(0x2B, 0x1017, 0, 50);  // heartbeat every 50ms
+  check(r && r->data[0] == 0x60 && ObjDict_obj1017 == 50, "SDO expedited download of 0x1017");
+
+  r = sdoRequest(0x40, 0x5FFF, 0, 0);
+  check(r && r->data[0] == 0x80 && r->data[7] == 0x06 && r->data[6] == 0x02,
+        "SDO abort, object does not exist");
+
+  nbSent = 0;
+  runFor(280);
+  for (i = 0; i < nbSent; i++)
+    if (sent[i].cob_id == 0x700 + NODE_ID)
+      heartbeats++;
+  printf("      %d heartbeats in 280ms\n", heartbeats);
+  check(heartbeats >= 4 && heartbeats <= 6, "heartbeat produced from the polled timer");
+
+  printf("%s\n", failures ? "smoke test FAILED" : "smoke test passed");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+/*
+This file is part of CanFestival, a library implementing CanOpen Stack.
+
+Copyright (C): Edouard TISSERANT and Francis DUPIN
+Linux host port for the rmStim node
+
+See COPYING file for copyrights details.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file   timer_bench.c
+ * @brief Host benchmark of the alarm queue (timer.c), built once per MAX_NB_TIMER.  The
+ *        driver is simulated: each alarm fires exactly when programmed, so only the CPU
+ *        time of timer.c is measured.
+ *        - set+del: SetAlarm and DelAlarm of a one-shot with every other row armed
+ *        - dispatch: TimeDispatch and TimerDispatchPending of one alarm, every row armed
+ *          with a different period
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "canfestival.h"
+#include "timer.h"
+#include "ObjDict.h"
+
+#define SET_DEL_LOOPS   1000000L
+#define DISPATCH_LOOPS  1000000L
+
+// 0x2016, defined by ObjDict.c in the node
+UNS32 TimerStat_DispatchLag;
+UNS32 TimerStat_MaxDispatchLag;
+UNS32 TimerStat_DeferredCount;
+
+// -- the timer driver, simulated --
+void setTimer(TIMEVAL value)
+{
+}
+
+TIMEVAL getElapsedTime(void)
+{
+  return 0;                             // always called at the alarm, the reference
+}
+
+static UNS32 fired;
+
+static void benchCallback(CO_Data* d, UNS32 id)
+{
+  fired++;
+}
+
+static double nsSince(const struct timespec *t)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - t->tv_sec) * 1e9 + (now.tv_nsec - t->tv_nsec);
+}
+
+int main(void)
+{
+  struct timespec start;
+  double setDel, dispatch;
+  TIMER_HANDLE h;
+  long i;
+
+  for (i = 0; i < MAX_NB_TIMER - 1; i++)
+    SetAlarm(NULL, i, &benchCallback, 1000 + 37 * i, 1000 + 37 * i);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < SET_DEL_LOOPS; i++)
+  {
+    h = SetAlarm(NULL, 0, &benchCallback, 500 + (i & 1023), 0);
+    DelAlarm(h);
+  }
+  setDel = nsSince(&start) / SET_DEL_LOOPS;
+
+  SetAlarm(NULL, MAX_NB_TIMER - 1, &benchCallback, 3000, 3000);
+  fired = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < DISPATCH_LOOPS; i++)
+  {
+    TimeDispatch();
+    TimerDispatchPending();
+  }
+  dispatch = nsSince(&start) / fired;
+
+  printf("%3d timers  set+del %6.1f ns  dispatch %6.1f ns per alarm  (%lu alarms)\n",
+         MAX_NB_TIMER, setDel, dispatch, (unsigned long)fired);
+  return 0;
+}
@@ -0,0 +1,111 @@
+/*
+This file is part of CanFestival, a library implementing CanOpen Stack.
+
+Copyright (C): Edouard TISSERANT and Francis DUPIN
+Linux host port for the rmStim node
+
+See COPYING file for copyrights details.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/**
+ * @file   timer_linux.c
+ * @brief Linux host implementation of the CANopen timer driver.  There is no timer
+ *        interrupt: the host main loop calls TimerPoll(), which runs TimeDispatch() 
+ *        once the alarm set by the stack is due.  TIMEVAL ticks are 8us, as tmr3, and
+ *        alarms are relative to the last alarm, as OCR3B.
+ */
+
+#include <time.h>
+
+#include "canfestival.h"
+#include "timer.h"
+
+/************************** Module variables **********************************/
+static struct timespec last_occured;     // time of the last alarm, the timer reference
+static TIMEVAL next_alarm = TIMEVAL_MAX; // ticks after last_occured of the next alarm
+
+/**
+ * @brief Ticks (8us) elapsed since t
+ */
+static TIMEVAL ticksSince(const struct timespec *t)
+{
+  struct timespec now;
+  UNS64 us;
+  
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  us = (UNS64)(now.tv_sec - t->tv_sec) * 1000000 + (now.tv_nsec - t->tv_nsec) / 1000;
+  return (TIMEVAL)(us / TIMER_TICK_US);
+}
+
+/**
+ * @brief Starts the time base
+*/
+void initTimer(void)
+{
+  clock_gettime(CLOCK_MONOTONIC, &last_occured);
+  next_alarm = TIMEVAL_MAX;
+}
+
+/**
+ * @brief Set the timer for the next alarm.
+ * @param value TIMEVAL ticks after the reference, the last alarm
+ */
+void setTimer(TIMEVAL value)
+{
+  next_alarm = value;
+}
+
+/**
+ * @brief Return the elapsed time to tell the Stack how much time is spent since last call.
+ * @return value TIMEVAL the elapsed time
+ */
+TIMEVAL getElapsedTime(void)
+{
+  return ticksSince(&last_occured);
+}
+
+/**
+ * @brief Runs the stack's timer handler when the alarm is due, takes the place of the 
+ *   tmr3 compare interrupt
+ */
+void TimerPoll(void)
+{
+  if (ticksSince(&last_occured) >= next_alarm)
+  {
+    UNS64 ns = (UNS64)next_alarm * TIMER_TICK_US * 1000 + last_occured.tv_nsec;
+    
+    // the reference moves to the alarm that fired, the poll latency shows as overrun
+    last_occured.tv_sec += ns / 1000000000;
+    last_occured.tv_nsec = ns % 1000000000;
+    next_alarm = TIMEVAL_MAX;
+    TimeDispatch();
+  }
+  TimerDispatchPending();               // already in the main loop, run the deferred callbacks now
+}
+
+/**
+ * @brief Time until the next alarm, for poll()/select() in the host main loop
+ * @return ms (rounded up) until TimerPoll has work
+ */
+int TimerWaitMs(void)
+{
+  TIMEVAL elapsed = ticksSince(&last_occured);
+  
+  if (elapsed >= next_alarm)
+    return 0;
+  return (int)(((UNS64)(next_alarm - elapsed) * TIMER_TICK_US + 999) / 1000);
+}
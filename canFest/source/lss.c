@@ -677,12 +677,13 @@ UNS8 proceedLSS_Slave(CO_Data* d, Message* m )
 		else if(m->data[1]==LSS_WAITING_MODE){
 			MSG_WAR(0x3D24, "SlaveLSS switching to operational mode ", 0);
 			
-			/* If the nodeID has changed update it and put the node state to Initialisation. */
+			/* If the nodeID has changed update it and put the node state to Waiting (no Initialisation state here). */
 			if(d->lss_transfer.nodeID!=getNodeId(d)){
 				if(getNodeId(d)==0xFF){/* The nodeID was 0xFF; initialize the application*/
-					MSG_WAR(0x3D25, "The node Id has changed. Reseting to Initialisation state",0);
+					MSG_WAR(0x3D25, "The node Id has changed. Reseting to Waiting state",0);
 					setNodeId(d, d->lss_transfer.nodeID);
-					setState(d, Initialisation);
+					canSetRxFilters(d);	/* SDO server and node guarding filters follow the new id, no module reset here */
+					setState(d, Waiting);
 				}
 				else{/* The nodeID will be changed on NMT_Reset_Comunication Request*/
 				}
@@ -734,6 +735,12 @@ UNS8 proceedLSS_Slave(CO_Data* d, Message* m )
 				error_code=0xFF; /* Baud rate not supported*/
 				break; 		
 			}
+			/* the driver must be able to reach the rate exactly at its clock */
+			if(error_code==0 && !canBaudRateSupported(d->lss_transfer.baudRate)){
+				MSG_ERR(0x1D29, "Bit timing not supported",0);
+				d->lss_transfer.baudRate="none";
+				error_code=0x01; /* bit timing not supported */
+			}
 		}
 		else{
 			MSG_WAR(0x3D2A, "SlaveLSS not in configuration mode",0);
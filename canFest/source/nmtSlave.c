@@ -40,7 +40,7 @@
 #include "states.h"
 #include "canfestival.h"
 #include "sysdep.h"
-#include "objdict.h"
+#include "ObjDict.h"
 #include "eedata.h"
 #include "app.h"
 #include "stimTask.h"
@@ -163,6 +163,11 @@ void processNMTstateChange(CO_Data* d, Message *m)
           CAN_Receive_BEI = 0;
           CAN_Receive_Messages = 0;
           CAN_Transmit_Messages = 0;
+          CAN_RxQueueHighWater = 0;
+          CAN_RxQueueOverflows = 0;
+          CAN_TxQueueHighWater = 0;
+          CAN_TxQueueDrops = 0;
+          CAN_TxQueueMaxLatency = 0;
           break;   
           
        case NMT_Erase_Serial_Eprom:
@@ -210,25 +215,22 @@ void processNMTstateChange(CO_Data* d, Message *m)
         
         case NMT_Enter_Low_Power:
           //must be in waiting and targeted to this node
-          //assume that only way to come out of sleep mode is power cycle
+          //data[2]==1 cuts 3v3, only way to come out is power cycle
+          //otherwise sleep with peripherals off until the next CAN frame
           if ( ((*m).data[1] == *d->bDeviceNodeId) && (d->nodeState == Waiting))
           {
             if((*m).data[2]==1)
             {
+              EEPROM_Flush(); //queued EEPROM writes first
+#ifdef  __IAR_SYSTEMS_ICC__
               DDRE |= BIT7; //set 3v3 shutoff line as output
               PORTE &= ~BIT7; //set 3v3 shutoff line low to trigger shutoff
+#endif
             }
             else
             {
-              //do other power savings things here before sleeping
-              ADCSRA &= ~BIT7; //turn off ADC
-              sleepAccelerometer();
-              TWCR &= ~BIT2; //turn off I2C
-              PORTG &= ~BIT2; //turn off Heartbeat LED
-              
-              SMCR |= BIT2|BIT0; //Set Sleep Enable in Power-down mode
-              asm("SLEEP");
-             }
+              EnterDeepSleep();
+            }
           }
           break;
             
@@ -333,6 +333,7 @@ UNS32 _setODentry( CO_Data* d,
         return errorCode;
       }
       memcpy(ptrTable->pSubindex[bSubindex].pObject,pSourceData, szData);
+      PDOMarkDirty(d, ptrTable->pSubindex[bSubindex].pObject);
      /* TODO : CONFORM TO DS-301 : 
       *  - stop using NULL terminated strings
       *  - store string size in td_subindex 
@@ -44,15 +44,14 @@
 
 /** 
  * @ingroup pdo
- * @brief Copy all the data to transmit in process_var
- * Prepare the PDO defined at index to be sent
- * *pwCobId : returns the value of the cobid. (subindex 1)
+ * @brief Decodes the mapping of a TPDO and copies every mapped variable through
+ * getODentry.  Used for mappings compilePDOMap cannot handle.
  * @param *d Pointer on a CAN object data structure
  * @param numPdo The PDO number
  * @param *pdo Pointer on a CAN message structure
  * @return 0 or 0xFF if error.
  */
-UNS8 buildPDO (CO_Data * d, UNS8 numPdo, Message * pdo)
+static UNS8 buildPDOfromOD (CO_Data * d, UNS8 numPdo, Message * pdo)
 {
   const indextable *TPDO_com = d->objdict + d->firstIndex->PDO_TRS + numPdo;
   const indextable *TPDO_map = d->objdict + d->firstIndex->PDO_TRS_MAP + numPdo;
@@ -115,6 +114,107 @@ UNS8 buildPDO (CO_Data * d, UNS8 numPdo, Message * pdo)
   return 0;
 }
 
+/** 
+ * @ingroup pdo
+ * @brief Compiles the mapping of a TPDO into direct pointers to the mapped variables, 
+ * so buildPDO does not look them up in the object dictionary on every SYNC.
+ * @details Mappings with a visible string, more than PDO_MAX_MAPPED objects or an
+ * object getODentry would refuse are left to buildPDOfromOD, which also reports 
+ * the error.  Big endian targets always use buildPDOfromOD as it swaps the bytes.
+ * @param *d Pointer on a CAN object data structure
+ * @param numPdo The PDO number
+ */
+static void compilePDOMap (CO_Data * d, UNS8 numPdo)
+{
+  const indextable *TPDO_map = d->objdict + d->firstIndex->PDO_TRS_MAP + numPdo;
+  s_PDO_status *status = &d->PDO_status[numPdo];
+  UNS8 count = *(UNS8 *) TPDO_map->pSubindex[0].pObject;
+  UNS8 offset = 0;
+  UNS8 i;
+
+  status->mapState = PDO_MAP_GENERIC;
+  status->mapCount = 0;
+#ifdef CANOPEN_BIG_ENDIAN
+  return;
+#endif
+  if (count > PDO_MAX_MAPPED || count >= TPDO_map->bSubCount)
+    return;
+
+  for (i = 0; i < count; i++)
+    {
+      UNS32 MappingParameter = *(UNS32 *) TPDO_map->pSubindex[i + 1].pObject;
+      UNS8 Size = (UNS8) (MappingParameter & (UNS32) 0x000000FF);      /* Size in bits */
+
+      /* same rule as buildPDOfromOD: skip empty entries and what overflows the frame */
+      if (Size && ((offset + Size) <= 64))
+        {
+          UNS8 subIndex = (UNS8) ((MappingParameter >> 8) & (UNS32) 0x000000FF);
+          UNS32 errorCode;
+          ODCallback_t *Callback;
+          const indextable *ptrTable =
+            (*d->scanIndexOD) ((UNS16) (MappingParameter >> 16), &errorCode, &Callback);
+          const subindex *pSubindex;
+          s_PDO_map *map;
+
+          if (errorCode != OD_SUCCESSFUL || subIndex >= ptrTable->bSubCount)
+            return;
+          pSubindex = &ptrTable->pSubindex[subIndex];
+          if (pSubindex->bDataType == visible_string ||
+              pSubindex->size != 1 + ((Size - 1) >> 3))
+            return;
+
+          map = &status->map[status->mapCount++];
+          map->pObject = (UNS8 *) pSubindex->pObject;
+          map->offset = offset;
+          map->bits = Size;
+          map->bytes = ((offset | Size) & 7) ? 0 : Size >> 3;
+          offset += Size;
+        }
+    }
+
+  status->mapLen = (offset + 7) >> 3;
+  status->mapState = PDO_MAP_READY;
+}
+
+/** 
+ * @ingroup pdo
+ * @brief Copy all the data to transmit in process_var
+ * Prepare the PDO defined at index to be sent, from the compiled mapping: byte 
+ * aligned objects are copied whole, only unaligned ones bit per bit
+ * *pwCobId : returns the value of the cobid. (subindex 1)
+ * @param *d Pointer on a CAN object data structure
+ * @param numPdo The PDO number
+ * @param *pdo Pointer on a CAN message structure
+ * @return 0 or 0xFF if error.
+ */
+UNS8 buildPDO (CO_Data * d, UNS8 numPdo, Message * pdo)
+{
+  const indextable *TPDO_com = d->objdict + d->firstIndex->PDO_TRS + numPdo;
+  s_PDO_status *status = &d->PDO_status[numPdo];
+  const s_PDO_map *map;
+  UNS8 i;
+
+  if (status->mapState == PDO_MAP_STALE)
+    compilePDOMap (d, numPdo);
+  if (status->mapState != PDO_MAP_READY)
+    return buildPDOfromOD (d, numPdo, pdo);
+
+  pdo->cob_id = UNS16_LE(*(UNS32*)TPDO_com->pSubindex[1].pObject & 0x7FF);
+  pdo->rtr = NOT_A_REQUEST;
+
+  for (i = 0, map = status->map; i < status->mapCount; i++, map++)
+    {
+      if (map->bytes)
+        memcpy (&pdo->data[map->offset >> 3], map->pObject, map->bytes);
+      else      /* copy bit per bit in little endian */
+        CopyBits (map->bits, map->pObject, 0, 0,
+                  (UNS8 *) & pdo->data[map->offset >> 3], map->offset % 8, 0);
+    }
+  pdo->len = status->mapLen;
+
+  return 0;
+}
+
 /** 
  * @ingroup pdo
  * @brief Transmit a PDO request frame on the network to the slave.
@@ -160,6 +260,213 @@ UNS8 sendPDOrequest (CO_Data * d, UNS16 RPDOIndex)
   return 0xFF;
 }
 
+/**
+ * @ingroup pdo
+ * @brief Decodes the mapping of a RPDO and writes every mapped variable through
+ * setODentry.  Used for mappings compileRPDOMap cannot handle.
+ * @param *d Pointer on a CAN object data structure
+ * @param numPdo The RPDO number
+ * @param *m Pointer on a CAN message structure
+ * @return 0xFF if error, else return 0
+ */
+static UNS8 processRPDOfromOD (CO_Data * d, UNS8 numPdo, Message * m)
+{
+  const indextable *RPDO_map = d->objdict + d->firstIndex->PDO_RCV_MAP + numPdo;
+  UNS8 *pMappingCount = (UNS8 *) RPDO_map->pSubindex[0].pObject;       /* count of mapped objects... */
+  /* pointer fo the var which holds the mapping parameter of an
+     mapping entry */
+  UNS32 *pMappingParameter = NULL;
+  UNS8 numMap = 0;              /* Number of the mapped varable */
+  UNS8 offset = 0x00;
+  UNS8 Size;
+  UNS32 objDict;
+
+  while (numMap < *pMappingCount)
+    {
+      UNS8 tmp[] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+      UNS32 ByteSize;
+      pMappingParameter =
+        (UNS32 *) RPDO_map->pSubindex[numMap + 1].pObject;
+      if (pMappingParameter == NULL)
+        {
+          MSG_ERR (0x1937, "Couldn't get mapping parameter : ",
+                   numMap + 1);
+          return 0xFF;
+        }
+      /* Get the addresse of the mapped variable. */
+      /* detail of *pMappingParameter : */
+      /* The 16 hight bits contains the index, the medium 8 bits
+         contains the subindex, */
+      /* and the lower 8 bits contains the size of the mapped
+         variable. */
+
+      Size = (UNS8) (*pMappingParameter & (UNS32) 0x000000FF);
+
+      /* set variable only if Size != 0 and 
+       * Size is lower than remaining bits in the PDO */
+      if (Size && ((offset + Size) <= (m->len << 3)))
+        {
+          /* copy bit per bit in little endian */
+          CopyBits (Size, (UNS8 *) & m->data[offset >> 3],
+                    offset % 8, 0, ((UNS8 *) tmp), 0, 0);
+          /*1->8 => 1 ; 9->16 =>2, ... */
+          ByteSize = (UNS32)(1 + ((Size - 1) >> 3));
+
+          objDict =
+            setODentry (d, (UNS16) ((*pMappingParameter) >> 16),
+                        (UNS8) (((*pMappingParameter) >> 8) &
+                                0xFF), tmp, &ByteSize, 0);
+
+          if (objDict != OD_SUCCESSFUL)
+            {
+              MSG_ERR (0x1938,
+                       "error accessing to the mapped var : ",
+                       numMap + 1);
+              MSG_WAR (0x2939, "         Mapped at index : ",
+                       (*pMappingParameter) >> 16);
+              MSG_WAR (0x2940, "                subindex : ",
+                       ((*pMappingParameter) >> 8) & 0xFF);
+              return 0xFF;
+            }
+
+          MSG_WAR (0x3942,
+                   "Variable updated by PDO cobid : ",
+                   UNS16_LE(m->cob_id));
+          MSG_WAR (0x3943, "         Mapped at index : ",
+                   (*pMappingParameter) >> 16);
+          MSG_WAR (0x3944, "                subindex : ",
+                   ((*pMappingParameter) >> 8) & 0xFF);
+          offset += Size;
+        }
+      numMap++;
+    }             /* end loop while on mapped variables */
+
+  return 0;
+}
+
+/**
+ * @ingroup pdo
+ * @brief Compiles the COB-ID and the mapping of a RPDO into a write plan: the 
+ * destination of each mapped object, its place in the frame, and whether it needs a
+ * range test or storing.  Callbacks are looked up at reception as PDOInit and the 
+ * application may register them later.
+ * @details Mappings with a visible string, more than PDO_MAX_MAPPED objects or an
+ * object setODentry would refuse are left to processRPDOfromOD, which also reports 
+ * the error.  Big endian targets always use processRPDOfromOD as it swaps the bytes.
+ * @param *d Pointer on a CAN object data structure
+ * @param numPdo The RPDO number
+ */
+static void compileRPDOMap (CO_Data * d, UNS8 numPdo)
+{
+  const indextable *RPDO_com = d->objdict + d->firstIndex->PDO_RCV + numPdo;
+  const indextable *RPDO_map = d->objdict + d->firstIndex->PDO_RCV_MAP + numPdo;
+  s_RPDO_status *status = &d->RPDO_status[numPdo];
+  UNS32 cobId = *(UNS32 *) RPDO_com->pSubindex[1].pObject;
+  UNS8 count = *(UNS8 *) RPDO_map->pSubindex[0].pObject;
+  UNS8 offset = 0;
+  UNS8 i;
+
+  /* same rule as canSetRxFilters */
+  status->cob_id = (cobId & 0x80000000) ? 0 : (UNS16) cobId & 0x7FF;
+  status->mapState = PDO_MAP_GENERIC;
+  status->mapCount = 0;
+#ifdef CANOPEN_BIG_ENDIAN
+  return;
+#endif
+  if (count > PDO_MAX_MAPPED || count >= RPDO_map->bSubCount)
+    return;
+
+  for (i = 0; i < count; i++)
+    {
+      UNS32 MappingParameter = *(UNS32 *) RPDO_map->pSubindex[i + 1].pObject;
+      UNS8 Size = (UNS8) (MappingParameter & (UNS32) 0x000000FF);      /* Size in bits */
+
+      if (Size && ((offset + Size) <= 64))
+        {
+          UNS8 subIndex = (UNS8) ((MappingParameter >> 8) & (UNS32) 0x000000FF);
+          UNS32 errorCode;
+          ODCallback_t *Callback;
+          const indextable *ptrTable =
+            (*d->scanIndexOD) ((UNS16) (MappingParameter >> 16), &errorCode, &Callback);
+          const subindex *pSubindex;
+          s_RPDO_map *map;
+
+          if (errorCode != OD_SUCCESSFUL || subIndex >= ptrTable->bSubCount)
+            return;
+          pSubindex = &ptrTable->pSubindex[subIndex];
+          if (pSubindex->bDataType == visible_string ||
+              pSubindex->size != 1 + ((Size - 1) >> 3))
+            return;
+
+          map = &status->map[status->mapCount++];
+          map->pObject = (UNS8 *) pSubindex->pObject;
+          map->ptrTable = ptrTable;
+          map->callbacks = Callback;
+          map->bSubindex = subIndex;
+          map->dataType = pSubindex->bDataType;
+          map->offset = offset;
+          map->bits = Size;
+          map->size = pSubindex->size;
+          map->flags = 0;
+          if (!((offset | Size) & 7))
+            map->flags |= RPDO_MAP_ALIGNED;
+          if (pSubindex->bDataType >= 0x24)    /* value range types, see objdictdef.h */
+            map->flags |= RPDO_MAP_RANGE;
+          if (pSubindex->bAccessType & TO_BE_SAVE)
+            map->flags |= RPDO_MAP_SAVE;
+          offset += Size;
+        }
+    }
+
+  status->mapState = PDO_MAP_READY;
+}
+
+/**
+ * @ingroup pdo
+ * @brief Writes a received RPDO through its compiled plan.  Objects that are not 
+ * entirely in the frame are not written.
+ * @param *d Pointer on a CAN object data structure
+ * @param *status The compiled RPDO
+ * @param *m Pointer on a CAN message structure
+ * @return 0xFF if error, else return 0
+ */
+static UNS8 writeRPDOMap (CO_Data * d, const s_RPDO_status * status, Message * m)
+{
+  const s_RPDO_map *map;
+  UNS8 i;
+
+  for (i = 0, map = status->map; i < status->mapCount; i++, map++)
+    {
+      UNS8 tmp[] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+      UNS8 *pData = tmp;
+
+      if (map->offset + map->bits > (m->len << 3))
+        continue;
+      if (map->flags & RPDO_MAP_ALIGNED)
+        pData = (UNS8 *) & m->data[map->offset >> 3];
+      else      /* copy bit per bit in little endian */
+        CopyBits (map->bits, (UNS8 *) & m->data[map->offset >> 3],
+                  map->offset % 8, 0, tmp, 0, 0);
+
+      if ((map->flags & RPDO_MAP_RANGE) &&
+          (*d->valueRangeTest) (map->dataType, pData) != OD_SUCCESSFUL)
+        {
+          MSG_ERR (0x1938, "error accessing to the mapped var : ", i + 1);
+          return 0xFF;
+        }
+      memcpy (map->pObject, pData, map->size);
+      PDOMarkDirty (d, map->pObject);
+
+      if (map->callbacks && map->callbacks[map->bSubindex] &&
+          (map->callbacks[map->bSubindex]) (d, map->ptrTable, map->bSubindex) != OD_SUCCESSFUL)
+        return 0xFF;
+      if (map->flags & RPDO_MAP_SAVE)
+        (*d->storeODSubIndex) (d, map->ptrTable->index, map->bSubindex);
+    }
+
+  return 0;
+}
+
 /**
  * @ingroup pdo
  * @brief Compute a PDO frame reception
@@ -171,29 +478,15 @@ UNS8 sendPDOrequest (CO_Data * d, UNS16 RPDOIndex)
 UNS8 processPDO (CO_Data * d, Message * m)
 {
   UNS8 numPdo;
-  UNS8 numMap;                  /* Number of the mapped varable */
-  UNS8 *pMappingCount = NULL;   /* count of mapped objects... */
-  /* pointer to the var which is mapped to a pdo... */
-  /*  void *     pMappedAppObject = NULL;   */
-  /* pointer fo the var which holds the mapping parameter of an
-     mapping entry */
-  UNS32 *pMappingParameter = NULL;
   UNS8 *pTransmissionType = NULL;       /* pointer to the transmission
                                            type */
   UNS32 *pwCobId = NULL;
-  UNS8 Size;
-  UNS8 offset;
   UNS8 status;
-  UNS32 objDict;
   UNS16 offsetObjdict;
   UNS16 lastIndex;
 
-  status = state2;
-
   MSG_WAR (0x3935, "proceedPDO, cobID : ", (UNS16_LE(m->cob_id) & 0x7ff));
-  offset = 0x00;
   numPdo = 0;
-  numMap = 0;
   if ((*m).rtr == NOT_A_REQUEST)
     {                           /* The PDO received is not a
                                    request. */
@@ -201,114 +494,22 @@ UNS8 processPDO (CO_Data * d, Message * m)
       offsetObjdict = d->firstIndex->PDO_RCV;
       lastIndex = d->lastIndex->PDO_RCV;
 
-      /* study of all the PDO stored in the dictionary */
+      /* look the COB-ID up in the compiled RPDOs */
       if (offsetObjdict)
-        while (offsetObjdict <= lastIndex)
+        for (; offsetObjdict <= lastIndex; offsetObjdict++, numPdo++)
           {
+            s_RPDO_status *rpdo = &d->RPDO_status[numPdo];
 
-            switch (status)
-              {
-
-              case state2:
-                /* get CobId of the dictionary correspondant to the received
-                   PDO */
-                pwCobId =
-                  d->objdict[offsetObjdict].pSubindex[1].pObject;
-                /* check the CobId coherance */
-                /*pwCobId is the cobId read in the dictionary at the state 3
-                 */
-                if (*pwCobId == UNS16_LE(m->cob_id))
-                  {
-                    /* The cobId is recognized */
-                    status = state4;
-                    MSG_WAR (0x3936, "cobId found at index ",
-                             0x1400 + numPdo);
-                    break;
-                  }
-                else
-                  {
-                    /* cobId received does not match with those write in the
-                       dictionnary */
-                    numPdo++;
-                    offsetObjdict++;
-                    status = state2;
-                    break;
-                  }
-
-              case state4:     /* Get Mapped Objects Number */
-                /* The cobId of the message received has been found in the
-                   dictionnary. */
-                offsetObjdict = d->firstIndex->PDO_RCV_MAP;
-                lastIndex = d->lastIndex->PDO_RCV_MAP;
-                pMappingCount =
-                  (UNS8 *) (d->objdict + offsetObjdict +
-                            numPdo)->pSubindex[0].pObject;
-                numMap = 0;
-                while (numMap < *pMappingCount)
-                  {
-                    UNS8 tmp[] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-                    UNS32 ByteSize;
-                    pMappingParameter =
-                      (UNS32 *) (d->objdict + offsetObjdict +
-                                 numPdo)->pSubindex[numMap + 1].pObject;
-                    if (pMappingParameter == NULL)
-                      {
-                        MSG_ERR (0x1937, "Couldn't get mapping parameter : ",
-                                 numMap + 1);
-                        return 0xFF;
-                      }
-                    /* Get the addresse of the mapped variable. */
-                    /* detail of *pMappingParameter : */
-                    /* The 16 hight bits contains the index, the medium 8 bits
-                       contains the subindex, */
-                    /* and the lower 8 bits contains the size of the mapped
-                       variable. */
-
-                    Size = (UNS8) (*pMappingParameter & (UNS32) 0x000000FF);
-
-                    /* set variable only if Size != 0 and 
-                     * Size is lower than remaining bits in the PDO */
-                    if (Size && ((offset + Size) <= (m->len << 3)))
-                      {
-                        /* copy bit per bit in little endian */
-                        CopyBits (Size, (UNS8 *) & m->data[offset >> 3],
-                                  offset % 8, 0, ((UNS8 *) tmp), 0, 0);
-                        /*1->8 => 1 ; 9->16 =>2, ... */
-                        ByteSize = (UNS32)(1 + ((Size - 1) >> 3));
-
-                        objDict =
-                          setODentry (d, (UNS16) ((*pMappingParameter) >> 16),
-                                      (UNS8) (((*pMappingParameter) >> 8) &
-                                              0xFF), tmp, &ByteSize, 0);
-
-                        if (objDict != OD_SUCCESSFUL)
-                          {
-                            MSG_ERR (0x1938,
-                                     "error accessing to the mapped var : ",
-                                     numMap + 1);
-                            MSG_WAR (0x2939, "         Mapped at index : ",
-                                     (*pMappingParameter) >> 16);
-                            MSG_WAR (0x2940, "                subindex : ",
-                                     ((*pMappingParameter) >> 8) & 0xFF);
-                            return 0xFF;
-                          }
-
-                        MSG_WAR (0x3942,
-                                 "Variable updated by PDO cobid : ",
-                                 UNS16_LE(m->cob_id));
-                        MSG_WAR (0x3943, "         Mapped at index : ",
-                                 (*pMappingParameter) >> 16);
-                        MSG_WAR (0x3944, "                subindex : ",
-                                 ((*pMappingParameter) >> 8) & 0xFF);
-                        offset += Size;
-                      }
-                    numMap++;
-                  }             /* end loop while on mapped variables */
-
-                return 0;
+            if (rpdo->mapState == PDO_MAP_STALE)
+              compileRPDOMap (d, numPdo);
+            if (rpdo->cob_id != UNS16_LE(m->cob_id))
+              continue;
 
-              }                 /* end switch status */
-          }                     /* end while */
+            MSG_WAR (0x3936, "cobId found at index ", 0x1400 + numPdo);
+            if (rpdo->mapState == PDO_MAP_READY)
+              return writeRPDOMap (d, rpdo, m);
+            return processRPDOfromOD (d, numPdo, m);
+          }
     }                           /* end if Donnees */
   else if ((*m).rtr == REQUEST)
     {
@@ -499,6 +700,65 @@ UNS8 sendPDOevent (CO_Data * d)
 }
 
 
+/** 
+ * @ingroup pdo
+ * @brief Signals that a variable of the object dictionary changed, so the event
+ * driven TPDOs that map it are built and compared at the next _sendPDOevent, from
+ * SYNC, the event timer or the end of the inhibit time.  The others are skipped
+ * without being built.
+ * @details Called by setODentry and by processPDO for each RPDO mapped entry.
+ * Application code that writes a mapped variable directly must call it too, else
+ * the change is missed by acyclic SYNC TPDOs and at the end of an inhibit time, and
+ * only goes out with the event timer.
+ * TPDOs whose mapping is not compiled are always marked.  Safe from an isr: it only
+ * sets flags, and _sendPDOevent clears them before building.
+ * @param *d Pointer on a CAN object data structure
+ * @param *pObject The variable, or any byte of it
+ */
+void PDOMarkDirty (CO_Data * d, const void *pObject)
+{
+  PDOMarkDirtyRange (d, pObject, 1);
+}
+
+/** 
+ * @ingroup pdo
+ * @brief PDOMarkDirty for a run of bytes, such as an array whose elements are
+ * mapped one subindex each.
+ * @param *d Pointer on a CAN object data structure
+ * @param *pObject First byte written
+ * @param size Number of bytes written
+ */
+void PDOMarkDirtyRange (CO_Data * d, const void *pObject, UNS8 size)
+{
+  UNS8 pdoNum = 0x00;
+  UNS16 offsetObjdict = d->firstIndex->PDO_TRS;
+  UNS16 lastIndex = d->lastIndex->PDO_TRS;
+  const UNS8 *p = (const UNS8 *) pObject;
+
+  if (offsetObjdict)
+    while (offsetObjdict <= lastIndex)
+      {
+        s_PDO_status *status = &d->PDO_status[pdoNum];
+
+        if (status->mapState != PDO_MAP_READY)
+          status->dirty = 1;
+        else
+          {
+            const s_PDO_map *map = status->map;
+            UNS8 i;
+
+            for (i = 0; i < status->mapCount; i++, map++)
+              if (p + size > map->pObject && p < map->pObject + ((map->bits + 7) >> 3))
+                {
+                  status->dirty = 1;
+                  break;
+                }
+          }
+        pdoNum++;
+        offsetObjdict++;
+      }
+}
+
 /** 
  * @ingroup pdo
  * @brief Set timer for PDO event
@@ -511,6 +771,7 @@ void PDOEventTimerAlarm (CO_Data * d, UNS32 pdoNum)
   d->PDO_status[pdoNum].event_timer = TIMER_NONE;
   /* force emission of PDO by artificially changing last emitted */
   d->PDO_status[pdoNum].last_message.cob_id = 0;
+  d->PDO_status[pdoNum].dirty = 1;
   _sendPDOevent (d, 0);         /* not a Sync Event */
 }
 
@@ -545,7 +806,9 @@ UNS8 _sendPDOevent (CO_Data * d, UNS8 isSyncEvent)
   UNS16 offsetObjdictMap = d->firstIndex->PDO_TRS_MAP;
   UNS16 lastIndex = d->lastIndex->PDO_TRS;
   
+#ifdef  __IAR_SYSTEMS_ICC__
   DDRA = 0xFF;
+#endif
   
   
   /* study all PDO stored in the objects dictionary */
@@ -633,6 +896,15 @@ UNS8 _sendPDOevent (CO_Data * d, UNS8 isSyncEvent)
                 {
                   MSG_WAR (0x3968, "  PDO is on EVENT. Trans type : ",
                            *pTransmissionType);
+                  /* Nothing mapped changed since the last build -> go to next pdo */
+                  if (d->PDO_status[pdoNum].mapState == PDO_MAP_READY &&
+                      !d->PDO_status[pdoNum].dirty)
+                    {
+                      status = state11;
+                      break;
+                    }
+                  /* cleared before building, a change made meanwhile marks it again */
+                  d->PDO_status[pdoNum].dirty = 0;
                   memset(&pdo, 0, sizeof(pdo));
                   /*{
                     Message msg_init = Message_Initializer;
@@ -774,6 +1046,65 @@ UNS32 TPDO_Communication_Parameter_Callback (CO_Data * d,
   return 0;
 }
 
+/**
+ * @ingroup pdo
+ * @brief Reprograms the CAN acceptance filters when a RPDO COB-ID changes
+ * @param d
+ * @param OD_entry
+ * @param bSubindex
+ * @return always 0
+*/
+UNS32 RPDO_Communication_Parameter_Callback (CO_Data * d,
+                                       const indextable * OD_entry,
+                                       UNS8 bSubindex)
+{
+  const indextable *RPDO_com = d->objdict + d->firstIndex->PDO_RCV;
+
+  if (bSubindex == 1)           /* Changed COB-ID */
+    {
+      d->RPDO_status[OD_entry - RPDO_com].mapState = PDO_MAP_STALE;
+      canSetRxFilters (d);
+    }
+  return 0;
+}
+
+/**
+ * @ingroup pdo
+ * @brief Marks the write plan of a RPDO stale when its 0x1600 entry changes
+ * @param d
+ * @param OD_entry
+ * @param bSubindex
+ * @return always 0
+*/
+UNS32 RPDO_Mapping_Parameter_Callback (CO_Data * d,
+                                       const indextable * OD_entry,
+                                       UNS8 bSubindex)
+{
+  const indextable *RPDO_map = d->objdict + d->firstIndex->PDO_RCV_MAP;
+
+  d->RPDO_status[OD_entry - RPDO_map].mapState = PDO_MAP_STALE;
+  return 0;
+}
+
+/**
+ * @ingroup pdo
+ * @brief Marks the compiled mapping of a TPDO stale when its 0x1A00 entry changes
+ * @param d
+ * @param OD_entry
+ * @param bSubindex
+ * @return always 0
+*/
+UNS32 TPDO_Mapping_Parameter_Callback (CO_Data * d,
+                                       const indextable * OD_entry,
+                                       UNS8 bSubindex)
+{
+  const indextable *TPDO_map = d->objdict + d->firstIndex->PDO_TRS_MAP;
+
+  d->PDO_status[OD_entry - TPDO_map].mapState = PDO_MAP_STALE;
+  d->PDO_status[OD_entry - TPDO_map].dirty = 1;
+  return 0;
+}
+
 /** 
  * @ingroup pdo
  * @brief Initialize PDO feature 
@@ -781,11 +1112,55 @@ UNS32 TPDO_Communication_Parameter_Callback (CO_Data * d,
  */
 void PDOInit (CO_Data * d)
 {
+  /* For each RPDO communication parameters */
+  UNS16 pdoIndex = 0x1400;      /* OD index of RDPO */
+
+  UNS16 offsetObjdict = d->firstIndex->PDO_RCV;
+  UNS16 lastIndex = d->lastIndex->PDO_RCV;
+  if (offsetObjdict)
+    while (offsetObjdict <= lastIndex)
+      {
+        UNS32 errorCode;
+        ODCallback_t *CallbackList;
+        d->RPDO_status[pdoIndex - 0x1400].mapState = PDO_MAP_STALE;
+        scanIndexOD (d, pdoIndex, &errorCode, &CallbackList);
+        if (errorCode == OD_SUCCESSFUL && CallbackList)
+          {
+            /* COB-ID, reprograms the hardware acceptance filters */
+            CallbackList[1] = &RPDO_Communication_Parameter_Callback;
+          }
+        pdoIndex++;
+        offsetObjdict++;
+      }
+
+  /* For each RPDO mapping, compiled again at the next reception */
+  pdoIndex = 0x1600;
+
+  offsetObjdict = d->firstIndex->PDO_RCV_MAP;
+  lastIndex = d->lastIndex->PDO_RCV_MAP;
+  if (offsetObjdict)
+    while (offsetObjdict <= lastIndex)
+      {
+        UNS32 errorCode;
+        ODCallback_t *CallbackList;
+        UNS8 i;
+
+        scanIndexOD (d, pdoIndex, &errorCode, &CallbackList);
+        if (errorCode == OD_SUCCESSFUL && CallbackList)
+          {
+            /* Number of mapped objects and every mapping entry */
+            for (i = 0; i < d->objdict[offsetObjdict].bSubCount; i++)
+              CallbackList[i] = &RPDO_Mapping_Parameter_Callback;
+          }
+        pdoIndex++;
+        offsetObjdict++;
+      }
+
   /* For each TPDO mapping parameters */
-  UNS16 pdoIndex = 0x1800;      /* OD index of TDPO */
+  pdoIndex = 0x1800;            /* OD index of TDPO */
 
-  UNS16 offsetObjdict = d->firstIndex->PDO_TRS;
-  UNS16 lastIndex = d->lastIndex->PDO_TRS;
+  offsetObjdict = d->firstIndex->PDO_TRS;
+  lastIndex = d->lastIndex->PDO_TRS;
   if (offsetObjdict)
     while (offsetObjdict <= lastIndex)
       {
@@ -808,6 +1183,31 @@ void PDOInit (CO_Data * d)
         offsetObjdict++;
       }
 
+  /* For each TPDO mapping, compiled again at the next build */
+  pdoIndex = 0x1A00;
+
+  offsetObjdict = d->firstIndex->PDO_TRS_MAP;
+  lastIndex = d->lastIndex->PDO_TRS_MAP;
+  if (offsetObjdict)
+    while (offsetObjdict <= lastIndex)
+      {
+        UNS32 errorCode;
+        ODCallback_t *CallbackList;
+        UNS8 i;
+
+        d->PDO_status[pdoIndex - 0x1A00].mapState = PDO_MAP_STALE;
+        d->PDO_status[pdoIndex - 0x1A00].dirty = 1;
+        scanIndexOD (d, pdoIndex, &errorCode, &CallbackList);
+        if (errorCode == OD_SUCCESSFUL && CallbackList)
+          {
+            /* Number of mapped objects and every mapping entry */
+            for (i = 0; i < d->objdict[offsetObjdict].bSubCount; i++)
+              CallbackList[i] = &TPDO_Mapping_Parameter_Callback;
+          }
+        pdoIndex++;
+        offsetObjdict++;
+      }
+
   /* Trigger a non-sync event */
   //_sendPDOevent (d, 0);
 }
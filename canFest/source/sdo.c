@@ -103,6 +103,31 @@ INLINE UNS8 _readNetworkDict (CO_Data* d, UNS8 nodeId, UNS16 index, UNS8 subInde
  */
 #define getSDOsubIndex(byte3) (byte3)
 
+/** Returns the block transfer sub command (cs, ss) from the first byte of the SDO
+ */
+#define getSDOblockSC(byte) (byte & 3)
+
+/** Returns the CRC support indicator (cc, sc) from the first byte of a block initiate SDO
+ */
+#define getSDOcc(byte) ((byte >> 2) & 1)
+
+/** Returns the number of bytes without data in the last segment from the first byte of a block end SDO
+ */
+#define getSDOblockN(byte) ((byte >> 2) & 7)
+
+/** Returns the sequence number from the first byte of a block segment
+ */
+#define getSDOseqno(byte) (byte & 0x7F)
+
+/** Returns the indicator of last block segment from the first byte of the SDO
+ */
+#define getSDOblockC(byte) ((byte >> 7) & 1)
+
+/** True when the current block upload sub-block has been sent : blksize segments,
+ *  or the last one of the data
+ */
+#define SDO_BLOCK_SENT(t) ((t).seqno && ((t).seqno == (t).blksize || (t).offset == (t).count))
+
 /** 
  * @ingroup sdo
  * @brief Reset of a SDO exchange on timeout.
@@ -160,6 +185,34 @@ void resetSDO (CO_Data* d)
       resetSDOline(d, j);
 }
 
+/** 
+ * @ingroup sdo
+ * @brief Gives the line a data buffer of the pool, if it has none yet.
+ * A buffer is free when no line points to it. resetSDOline releases it.
+ * @param *d Pointer on a CAN object data structure
+ * @param line SDO line
+ * @return 0xFF if every buffer is in use. Else, returns 0.
+ */
+static UNS8 getSDObuffer (CO_Data* d, UNS8 line)
+{
+  UNS8 i;
+  UNS8 j;
+
+  if (d->transfers[line].data)
+    return 0;
+  for (i = 0 ; i < SDO_BUFFER_POOL_SIZE ; i++) {
+    for (j = 0 ; j < SDO_MAX_SIMULTANEOUS_TRANSFERTS ; j++)
+      if (d->transfers[j].data == d->sdoBuffers[i])
+        break;
+    if (j == SDO_MAX_SIMULTANEOUS_TRANSFERTS) {
+      d->transfers[line].data = d->sdoBuffers[i];
+      return 0;
+    }
+  }
+  MSG_ERR(0x1A17, "SDO error : No free buffer in the pool for line ", line);
+  return 0xFF;
+}
+
 /** 
  * @ingroup sdo
  * @brief Copy the data received from the SDO line transfert to the object dictionary.
@@ -175,6 +228,12 @@ UNS32 SDOlineToObjdict (CO_Data* d, UNS8 line)
   /* if SDO initiated with e=0 and s=0 count is null, offset carry effective size*/
   if( d->transfers[line].count == 0)
   	d->transfers[line].count = d->transfers[line].offset;
+  /* a streamed domain already has its data, it is told the download is complete */
+  if (d->transfers[line].stream)
+    return (*d->transfers[line].stream->write)(d, d->transfers[line].stream,
+                                                 d->transfers[line].offset, NULL, 0);
+  if (getSDObuffer(d, line))
+    return SDOABT_OUT_OF_MEMORY;
   size = d->transfers[line].count;
   errorCode = setODentry(d, d->transfers[line].index, d->transfers[line].subIndex,
 			 (void *) d->transfers[line].data, &size, 1);
@@ -201,6 +260,15 @@ UNS32 objdictToSDOline (CO_Data* d, UNS8 line)
   MSG_WAR(0x3A05, "objdict->line index : ", d->transfers[line].index);
   MSG_WAR(0x3A06, "  subIndex : ", d->transfers[line].subIndex);
 
+  /* a streamed domain is read segment by segment by lineToSDO */
+  if (d->transfers[line].stream) {
+    d->transfers[line].count = d->transfers[line].stream->size;
+    d->transfers[line].offset = 0;
+    return 0;
+  }
+
+  if (getSDObuffer(d, line))
+    return SDOABT_OUT_OF_MEMORY;
   errorCode = getODentry(d, 	d->transfers[line].index,
   				d->transfers[line].subIndex,
   				(void *)d->transfers[line].data,
@@ -279,6 +347,8 @@ UNS32 objdictToSDOBlockline(CO_Data* d, UNS8 line, UNS8 numberOfIndexes)
   
   } // end of for loop
 
+  if (getSDObuffer(d, line))
+    return SDOABT_OUT_OF_MEMORY;
   d->transfers[line].count = size;
   d->transfers[line].offset = 0;
   d->transfers[line].dataType = 0x05; // change to bytes
@@ -301,6 +371,22 @@ UNS8 lineToSDO (CO_Data* d, UNS8 line, UNS32 nbBytes, UNS8* data) {
   UNS8 i;
   UNS32 offset;
 
+  if (d->transfers[line].stream) {
+    if ((d->transfers[line].offset + nbBytes) > d->transfers[line].count) {
+      MSG_ERR(0x1A12,"SDO Size of data too large. Exceed count", nbBytes);
+      return 0xFF;
+    }
+    d->transfers[line].abortCode = (*d->transfers[line].stream->read)(d, d->transfers[line].stream,
+                                      d->transfers[line].offset, data, (UNS8)nbBytes);
+    if (d->transfers[line].abortCode)
+      return 0xFF;
+    d->transfers[line].offset = d->transfers[line].offset + nbBytes;
+    return 0;
+  }
+  if (d->transfers[line].data == NULL) {
+    MSG_ERR(0x1A13,"SDO Nothing to send on line ", line);
+    return 0xFF;
+  }
   if ((d->transfers[line].offset + nbBytes) > SDO_MAX_LENGTH_TRANSFERT) {
     MSG_ERR(0x1A10,"SDO Size of data too large. Exceed SDO_MAX_LENGTH_TRANSFERT", nbBytes);
     return 0xFF;
@@ -330,8 +416,26 @@ UNS8 SDOtoLine (CO_Data* d, UNS8 line, UNS32 nbBytes, UNS8* data)
   UNS8 i;
   UNS32 offset;
 
+  if (d->transfers[line].stream) {
+    if ((d->transfers[line].offset + nbBytes) > d->transfers[line].stream->size) {
+      MSG_ERR(0x1A16,"SDO Size of data too large. Exceed the domain", nbBytes);
+      d->transfers[line].abortCode = SDOABT_OUT_OF_MEMORY;
+      return 0xFF;
+    }
+    d->transfers[line].abortCode = (*d->transfers[line].stream->write)(d, d->transfers[line].stream,
+                                      d->transfers[line].offset, data, (UNS8)nbBytes);
+    if (d->transfers[line].abortCode)
+      return 0xFF;
+    d->transfers[line].offset = d->transfers[line].offset + nbBytes;
+    return 0;
+  }
+  if (getSDObuffer(d, line)) {
+    d->transfers[line].abortCode = SDOABT_OUT_OF_MEMORY;
+    return 0xFF;
+  }
   if ((d->transfers[line].offset + nbBytes) > SDO_MAX_LENGTH_TRANSFERT) {
     MSG_ERR(0x1A15,"SDO Size of data too large. Exceed SDO_MAX_LENGTH_TRANSFERT", nbBytes);
+    d->transfers[line].abortCode = SDOABT_OUT_OF_MEMORY;
     return 0xFF;
   }
   offset = d->transfers[line].offset;
@@ -393,8 +497,11 @@ void resetSDOline ( CO_Data* d, UNS8 line )
   UNS32 i;
   MSG_WAR(0x3A25, "reset SDO line nb : ", line);
   initSDOline(d, line, 0, 0, 0, SDO_RESET);
-  for (i = 0 ; i < SDO_MAX_LENGTH_TRANSFERT ; i++)
-    d->transfers[line].data[i] = 0;
+  if (d->transfers[line].data) {
+    for (i = 0 ; i < SDO_MAX_LENGTH_TRANSFERT ; i++)
+      d->transfers[line].data[i] = 0;
+    d->transfers[line].data = NULL;
+  }
   d->transfers[line].whoami = 0;
   d->transfers[line].abortCode = 0;
 }
@@ -413,7 +520,8 @@ void resetSDOline ( CO_Data* d, UNS8 line )
 UNS8 initSDOline (CO_Data* d, UNS8 line, UNS8 nodeId, UNS16 index, UNS8 subIndex, UNS8 state)
 {
   MSG_WAR(0x3A25, "init SDO line nb : ", line);
-  if (state == SDO_DOWNLOAD_IN_PROGRESS || state == SDO_UPLOAD_IN_PROGRESS)
+  if (state == SDO_DOWNLOAD_IN_PROGRESS || state == SDO_UPLOAD_IN_PROGRESS ||
+      state == SDO_BLOCK_DOWNLOAD_IN_PROGRESS || state == SDO_BLOCK_UPLOAD_INIT)
   {
   	StartSDO_TIMER(line)
   }else
@@ -429,6 +537,14 @@ UNS8 initSDOline (CO_Data* d, UNS8 line, UNS8 nodeId, UNS16 index, UNS8 subIndex
   d->transfers[line].offset = 0;
   d->transfers[line].dataType = 0;
   d->transfers[line].Callback = NULL;
+  d->transfers[line].blksize = 0;
+  d->transfers[line].seqno = 0;
+  d->transfers[line].crcOn = 0;
+  d->transfers[line].blockStart = 0;
+  d->transfers[line].crc = 0;
+  d->transfers[line].crcCount = 0;
+  d->transfers[line].holding = 0;
+  d->transfers[line].stream = NULL;
   return 0;
 }
 
@@ -532,7 +648,7 @@ UNS8 getSDOlineRestBytes (CO_Data* d, UNS8 line, UNS32 * nbBytes)
  */
 UNS8 setSDOlineRestBytes (CO_Data* d, UNS8 line, UNS32 nbBytes)
 {
-  if (nbBytes > SDO_MAX_LENGTH_TRANSFERT) {
+  if (nbBytes > (d->transfers[line].stream ? d->transfers[line].stream->size : SDO_MAX_LENGTH_TRANSFERT)) {
     MSG_ERR(0x1A35,"SDO Size of data too large. Exceed SDO_MAX_LENGTH_TRANSFERT", nbBytes);
     return 0xFF;
   }
@@ -566,13 +682,14 @@ UNS8 sendSDO (CO_Data* d, UNS8 whoami, s_SDO sdo)
   }
 
   /*get the server->client cobid*/
-  if ( whoami == SDO_SERVER )	{/*case server. only one SDO server*/
+  if ( whoami == SDO_SERVER )	{/*case server. sdo.nodeId is the number of the server, from 0x1200 */
     offset = d->firstIndex->SDO_SVR;
-    if (offset == 0) 
+    if (offset == 0 || offset + sdo.nodeId > d->lastIndex->SDO_SVR) 
     {
-      MSG_ERR(0x1A42, "SendSDO : No SDO server found", 0);
+      MSG_ERR(0x1A42, "SendSDO : No SDO server found", sdo.nodeId);
       return 0xFF;
     }
+    offset += sdo.nodeId;
     pwCobId = (UNS32*) d->objdict[offset].pSubindex[2].pObject;
     MSG_WAR(0x3A41, "I am server. cobId : ", *pwCobId);
   }
@@ -645,14 +762,8 @@ UNS8 sendSDOabort (CO_Data* d, UNS8 whoami, UNS8 nodeID, UNS16 index, UNS8 subIn
   UNS8 ret;
   
   MSG_WAR(0x2A50,"Sending SDO abort ", abortCode);
-  if(whoami == SDO_SERVER)
-  {
-	sdo.nodeId = *d->bDeviceNodeId;
-  }
-  else
-  {
-    sdo.nodeId = nodeID;
-  }
+  /* The number of the server from 0x1200 if server, the node id of the server if client */
+  sdo.nodeId = nodeID;
   sdo.body.data[0] = 0x80;
   /* Index */
   sdo.body.data[1] = index & 0xFF; /* LSB */
@@ -669,6 +780,220 @@ UNS8 sendSDOabort (CO_Data* d, UNS8 whoami, UNS8 nodeID, UNS16 index, UNS8 subIn
   return ret;
 }
 
+/* CRC-16 CCITT (x^16 + x^12 + x^5 + 1, initial value 0) of the block transfers,
+   computed a nibble at a time */
+static const UNS16 SDOcrcTable[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/** 
+ * @ingroup sdo
+ * @brief CRC of a block transfer, as defined by CiA 301.
+ * @param crc CRC of the previous bytes, 0 to start
+ * @param *data Pointer on the data
+ * @param nbBytes
+ * @return the updated CRC
+ */
+static UNS16 SDOblockCRC (UNS16 crc, const UNS8 *data, UNS32 nbBytes)
+{
+  while (nbBytes--) {
+    crc = (crc << 4) ^ SDOcrcTable[((crc >> 12) ^ (*data >> 4)) & 0x0F];
+    crc = (crc << 4) ^ SDOcrcTable[((crc >> 12) ^ *data) & 0x0F];
+    data++;
+  }
+  return crc;
+}
+
+/** 
+ * @ingroup sdo
+ * @brief Server. Attaches the stream of the entry to the line when it is a domain.
+ * @param *d Pointer on a CAN object data structure
+ * @param line SDO line, index and subIndex set
+ * @param write 1 for a download, 0 for an upload
+ * @return 0, or the SDO abort code if the domain can not be moved that way.
+ * An unknown entry returns 0, the error is reported by the copy to or from the dictionary.
+ */
+static UNS32 openSDOstream (CO_Data* d, UNS8 line, UNS8 write)
+{
+  const indextable *ptrTable;
+  const subindex *pSubindex;
+  const ODStream *stream;
+  ODCallback_t *Callback;
+  UNS32 errorCode;
+
+  d->transfers[line].stream = NULL;
+  ptrTable = (*d->scanIndexOD)(d->transfers[line].index, &errorCode, &Callback);
+  if (errorCode != OD_SUCCESSFUL || ptrTable->bSubCount <= d->transfers[line].subIndex)
+    return 0;
+  pSubindex = &ptrTable->pSubindex[d->transfers[line].subIndex];
+  if (pSubindex->bDataType != domain)
+    return 0;
+  stream = (const ODStream *) pSubindex->pObject;
+  if (write && ((pSubindex->bAccessType & RO) || stream->write == NULL))
+    return OD_WRITE_NOT_ALLOWED;
+  if (!write && ((pSubindex->bAccessType & WO) || stream->read == NULL))
+    return OD_READ_NOT_ALLOWED;
+  d->transfers[line].stream = stream;
+  return 0;
+}
+
+/** 
+ * @ingroup sdo
+ * @brief Server. Sends the segments of the current sub-block of a block upload, from the
+ * line offset.  A sub-block ends after blksize segments, or with the last segment of the
+ * data (c = 1).
+ * @details Stops when the CAN transmit queue is full; sendSDOblockPending() goes on 
+ * from the main loop, so a client block size up to 127 does not overflow the queue.
+ * @param *d Pointer on a CAN object data structure
+ * @param line SDO line, blockStart and seqno set for the sub-block
+ * @return 0xFF if error. Else, returns 0.
+ */
+static UNS8 sendSDOblockSegments (CO_Data* d, UNS8 line)
+{
+  s_SDO sdo;
+  UNS32 nbBytes;
+  UNS32 offset;
+  UNS8 i;
+
+  sdo.nodeId = d->transfers[line].nodeId;
+  while (! SDO_BLOCK_SENT(d->transfers[line])) {
+    getSDOlineRestBytes(d, line, &nbBytes);
+    if (nbBytes > 7) {
+      sdo.body.data[0] = d->transfers[line].seqno + 1;
+      nbBytes = 7;
+    }
+    else {
+      /* Last segment. (c = 1) */
+      sdo.body.data[0] = 0x80 | (d->transfers[line].seqno + 1);
+      for (i = nbBytes + 1 ; i < 8 ; i++)
+        sdo.body.data[i] = 0;
+    }
+    offset = d->transfers[line].offset;
+    if (lineToSDO(d, line, nbBytes, sdo.body.data + 1))
+      return 0xFF;
+    if (sendSDO(d, SDO_SERVER, sdo) == 0) {
+      /* Transmit queue full, this segment is sent again later */
+      d->transfers[line].offset = offset;
+      return 0;
+    }
+    MSG_WAR(0x3AB3, "SDO. Sent block upload segment : ", d->transfers[line].seqno + 1);
+    d->transfers[line].seqno++;
+    /* The CRC covers each byte once, a repeated segment is already in */
+    if (d->transfers[line].crcOn && offset == d->transfers[line].crcCount) {
+      d->transfers[line].crc = SDOblockCRC(d->transfers[line].crc, sdo.body.data + 1, nbBytes);
+      d->transfers[line].crcCount += nbBytes;
+    }
+  }
+  return 0;
+}
+
+/** 
+ * @ingroup sdo
+ * @brief OD callback of the server SDO parameters (0x1200 + n, subindex 1).  Reprograms 
+ * the CAN acceptance filters, so a server whose client COB-ID is written receives its frames.
+ * @param *d Pointer on a CAN object data structure
+ * @param *OD_entry
+ * @param bSubindex
+ * @return always 0
+ */
+UNS32 SDO_Server_Parameter_Callback (CO_Data* d, const indextable *OD_entry, UNS8 bSubindex)
+{
+  if (bSubindex == 1)		/* Changed COB-ID client -> server */
+    canSetRxFilters (d);
+  return 0;
+}
+
+/** 
+ * @ingroup sdo
+ * @brief Server. Goes on with the block upload sub-blocks stopped by a full CAN 
+ * transmit queue.  To be called from the main loop.
+ * @param *d Pointer on a CAN object data structure
+ */
+void sendSDOblockPending (CO_Data* d)
+{
+  UNS8 line;
+
+  for (line = 0 ; line < SDO_MAX_SIMULTANEOUS_TRANSFERTS ; line++)
+    if (d->transfers[line].state == SDO_BLOCK_UPLOAD_IN_PROGRESS &&
+        ! SDO_BLOCK_SENT(d->transfers[line]) &&
+        sendSDOblockSegments(d, line))
+      failedSDO(d, d->transfers[line].nodeId, SDO_SERVER, d->transfers[line].index,
+                d->transfers[line].subIndex, SDOABT_GENERAL_ERROR);
+}
+
+/** 
+ * @ingroup sdo
+ * @brief Server. Stores the segment held by a block download in the line, or its stream.
+ * @param *d Pointer on a CAN object data structure
+ * @param line SDO line
+ * @param nbBytes bytes of data in the segment
+ * @return 0xFF if error, the abort code is then in the line. Else, returns 0.
+ */
+static UNS8 storeSDOblockSegment (CO_Data* d, UNS8 line, UNS8 nbBytes)
+{
+  d->transfers[line].holding = 0;
+  if (SDOtoLine(d, line, nbBytes, d->transfers[line].held))
+    return 0xFF;
+  if (d->transfers[line].crcOn)
+    d->transfers[line].crc = SDOblockCRC(d->transfers[line].crc, d->transfers[line].held, nbBytes);
+  return 0;
+}
+
+/** 
+ * @ingroup sdo
+ * @brief Server. Treats a segment of a block download.
+ * @details A segment carries a sequence number in place of the command specifier.
+ * Segments out of sequence are ignored, the acknowledge of the sub-block tells
+ * the client the last one received in sequence so it repeats the followings.
+ * A segment is held until the next one arrives, the padding of the last one 
+ * being only known from the end request.
+ * @param *d Pointer on a CAN object data structure
+ * @param nodeId
+ * @param line SDO line
+ * @param *m Pointer on a CAN message structure 
+ * @return 0xFF if error. Else, returns 0.
+ */
+static UNS8 processSDOblockSegment (CO_Data* d, UNS8 nodeId, UNS8 line, Message *m)
+{
+  s_SDO sdo;
+  UNS8 seqno = getSDOseqno(m->data[0]);
+  UNS8 i;
+
+  /* Reset the wathdog */
+  RestartSDO_TIMER(line)
+  if (seqno == d->transfers[line].seqno + 1) {
+    if (d->transfers[line].holding && storeSDOblockSegment(d, line, 7)) {
+      MSG_ERR(0x1AB3, "SDO error : Unable to store the block download segment", seqno);
+      failedSDO(d, nodeId, SDO_SERVER, d->transfers[line].index, d->transfers[line].subIndex,
+                d->transfers[line].abortCode);
+      return 0xFF;
+    }
+    for (i = 0 ; i < 7 ; i++)
+      d->transfers[line].held[i] = m->data[i + 1];
+    d->transfers[line].holding = 1;
+    d->transfers[line].seqno = seqno;
+    if (getSDOblockC(m->data[0]))
+      d->transfers[line].state = SDO_BLOCK_DOWNLOAD_END;
+  }
+  else
+    MSG_WAR(0x3AB4, "SDO. Block download segment out of sequence : ", seqno);
+
+  if (seqno == d->transfers[line].blksize || getSDOblockC(m->data[0])) {
+    /* End of sub-block. Sending the acknowledge, scs = 5, ss = 2 */
+    sdo.nodeId = nodeId;
+    sdo.body.data[0] = (5 << 5) | 2;
+    sdo.body.data[1] = d->transfers[line].seqno;
+    sdo.body.data[2] = d->transfers[line].blksize;
+    for (i = 3 ; i < 8 ; i++)
+      sdo.body.data[i] = 0;
+    MSG_WAR(0x3AB5, "SDO. Sending block download acknowledge. ackseq : ", d->transfers[line].seqno);
+    sendSDO(d, SDO_SERVER, sdo);
+    d->transfers[line].seqno = 0;
+  }
+  return 0;
+}
+
 /** 
  * @ingroup sdo
  * @brief Treat a SDO frame reception
@@ -768,8 +1093,15 @@ UNS8 processSDO (CO_Data* d, Message *m)
     MSG_WAR(0x3A69, "I am SERVER. Received SDO cobId : ", UNS16_LE(m->cob_id));
   }
 
+  /* A block download segment has a sequence number in place of the command specifier. */
+  /* Only an abort can interrupt the sub-block. */
+  if (whoami == SDO_SERVER && m->data[0] != 0x80 &&
+      ! getSDOlineOnUse( d, nodeId, whoami, &line ) &&
+      d->transfers[line].state == SDO_BLOCK_DOWNLOAD_IN_PROGRESS)
+    return processSDOblockSegment(d, nodeId, line, m);
+
   /* Testing the command specifier */
-  /* Allowed : cs = 0, 1, 2, 3, 4. (=  all except those for block tranfert). */
+  /* Allowed : cs = 0, 1, 2, 3, 4, 5 and 6 (block transfers are served, not requested). */
   /* cs = other : Not allowed -> abort. */
   switch (getSDOcs(m->data[0])) {
 
@@ -807,11 +1139,11 @@ UNS8 processSDO (CO_Data* d, Message *m)
       err = SDOtoLine(d, line, nbBytes, (*m).data + 1);
       if (err) 
       {
-	failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_GENERAL_ERROR);
+	failedSDO(d, nodeId, whoami, index, subIndex, d->transfers[line].abortCode);
 	return 0xFF;
       }
       /* Sending the SDO response, CS = 1 */
-      sdo.nodeId = *d->bDeviceNodeId; /* The node id of the server, (here it is the sender). */
+      sdo.nodeId = nodeId; /* The server node Id; */
       sdo.body.data[0] = (1 << 5) | (d->transfers[line].toggle << 4);
       for (i = 1 ; i < 8 ; i++)
 	sdo.body.data[i] = 0;
@@ -916,6 +1248,11 @@ UNS8 processSDO (CO_Data* d, Message *m)
 	return 0xFF;
       }
       initSDOline(d, line, nodeId, index, subIndex, SDO_DOWNLOAD_IN_PROGRESS);
+      errorCode = openSDOstream(d, line, 1);
+      if (errorCode) {
+	failedSDO(d, nodeId, whoami, index, subIndex, errorCode);
+	return 0xFF;
+      }
 
       if (getSDOe(m->data[0])) { /* If SDO expedited */
 	/* nb of data to be downloaded */
@@ -925,7 +1262,7 @@ UNS8 processSDO (CO_Data* d, Message *m)
 	err = SDOtoLine(d, line, nbBytes, (*m).data + 4);
 
 	if (err) {
-	  failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_GENERAL_ERROR);
+	  failedSDO(d, nodeId, whoami, index, subIndex, d->transfers[line].abortCode);
 	  return 0xFF;
 	}
 
@@ -946,15 +1283,15 @@ UNS8 processSDO (CO_Data* d, Message *m)
       {/* So, if it is not an expedited transfer */
 	if (getSDOs(m->data[0])) {
 	  nbBytes = (m->data[4]) + ((UNS32)(m->data[5])<<8) + ((UNS32)(m->data[6])<<16) + ((UNS32)(m->data[7])<<24);
-	  err = setSDOlineRestBytes(d, nodeId, nbBytes);
+	  err = setSDOlineRestBytes(d, line, nbBytes);
 	  if (err) {
-	    failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_GENERAL_ERROR);
+	    failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_OUT_OF_MEMORY);
 	    return 0xFF;
 	  }
 	}
       }
       /*Sending a SDO, cs=3*/
-      sdo.nodeId = *d->bDeviceNodeId; /* The node id of the server, (here it is the sender).*/
+      sdo.nodeId = nodeId; /* The server node Id; */
       sdo.body.data[0] = 3 << 5;
       sdo.body.data[1] = index & 0xFF;        /* LSB */
       sdo.body.data[2] = (index >> 8) & 0xFF; /* MSB */
@@ -1059,7 +1396,9 @@ UNS8 processSDO (CO_Data* d, Message *m)
       }
       initSDOline(d, line, nodeId, index, subIndex, SDO_UPLOAD_IN_PROGRESS);
       /* Transfer data from dictionary to the line structure. */
-      errorCode = objdictToSDOline(d, line);
+      errorCode = openSDOstream(d, line, 0);
+      if (!errorCode)
+        errorCode = objdictToSDOline(d, line);
 
       if (errorCode) {
 	MSG_ERR(0x1A94, "SDO error : Unable to copy the data from object dictionary. Err code : ",
@@ -1077,11 +1416,9 @@ UNS8 processSDO (CO_Data* d, Message *m)
 	sdo.body.data[1] = index & 0xFF;        /* LSB */
 	sdo.body.data[2] = (index >> 8) & 0xFF; /* MSB */
 	sdo.body.data[3] = subIndex;
-    sdo.body.data[4] = (UNS8)nbBytes; /* Limitation of canfestival2 : Max tranfert is 256 bytes.*/
-	/* It takes too much memory to upgrate to 2^32 because the size of data is also coded */
-	/* in the object dictionary, at every index and subindex. */
-	for (i = 5 ; i < 8 ; i++)
-	  sdo.body.data[i] = 0;
+	/* 32 bits size, a streamed domain may exceed 256 bytes */
+	for (i = 0 ; i < 4 ; i++)
+	  sdo.body.data[i + 4] = (UNS8)(nbBytes >> (i << 3));
 	MSG_WAR(0x3A95, "SDO. Sending normal upload initiate response defined at index 0x1200 + ", nodeId);
 	sendSDO(d, whoami, sdo);
       }
@@ -1319,8 +1656,150 @@ UNS8 processSDO (CO_Data* d, Message *m)
     
     case 5: // block upload
     /* I am SERVER */
+    /* Standard block upload. (ccs = 5) */
+#ifdef SDO_LEGACY_BLOCK_UPLOAD
+    if (whoami == SDO_SERVER && m->data[0] != (5 << 5))
+#else
+    if (whoami == SDO_SERVER)
+#endif
+    {
+      switch (getSDOblockSC(m->data[0])) {
+      case 0:
+        /* Initiate block upload. */
+        index = getSDOindex(m->data[1],m->data[2]);
+        subIndex = getSDOsubIndex(m->data[3]);
+        MSG_WAR(0x3AB6, "Received SDO Initiate block upload. Reading at index : ", index);
+        MSG_WAR(0x3AB6, "Reading at subIndex : ", subIndex);
+        err = getSDOlineOnUse( d, nodeId, whoami, &line );
+        if (! err) {
+          MSG_ERR(0x1AB4, "SDO error : Transmission yet started at line : ", line);
+          failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_LOCAL_CTRL_ERROR);
+          return 0xFF;
+        }
+        if (m->data[4] < 1 || m->data[4] > 127) {
+          MSG_ERR(0x1AB5, "SDO error : Invalid block size : ", m->data[4]);
+          failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_INVALID_BLOCK_SIZE);
+          return 0xFF;
+        }
+        err = getSDOfreeLine( d, whoami, &line );
+        if (err) {
+          MSG_ERR(0x1AB6, "SDO error : No line free, too many SDO in progress. Aborted.", 0);
+          failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_LOCAL_CTRL_ERROR);
+          return 0xFF;
+        }
+        initSDOline(d, line, nodeId, index, subIndex, SDO_BLOCK_UPLOAD_INIT);
+        errorCode = openSDOstream(d, line, 0);
+        if (!errorCode)
+          errorCode = objdictToSDOline(d, line);
+        if (errorCode) {
+          MSG_ERR(0x1AB7, "SDO error : Unable to copy the data from object dictionary. Err code : ",
+                  errorCode);
+          failedSDO(d, nodeId, whoami, index, subIndex, errorCode);
+          return 0xFF;
+        }
+        d->transfers[line].blksize = m->data[4];
+        d->transfers[line].crcOn = getSDOcc(m->data[0]);
+        /* Initiate block upload response. (scs = 6, sc = 1, s = 1, ss = 0) */
+        nbBytes = d->transfers[line].count;
+        sdo.nodeId = nodeId;
+        sdo.body.data[0] = (6 << 5) | (1 << 2) | (1 << 1);
+        sdo.body.data[1] = index & 0xFF;        /* LSB */
+        sdo.body.data[2] = (index >> 8) & 0xFF; /* MSB */
+        sdo.body.data[3] = subIndex;
+        for (i = 0 ; i < 4 ; i++)
+          sdo.body.data[i + 4] = (UNS8)(nbBytes >> (i << 3));
+        MSG_WAR(0x3AB7, "SDO. Sending block upload initiate response. Size : ", nbBytes);
+        sendSDO(d, whoami, sdo);
+        break;
+
+      case 3:
+        /* Start upload. Sending the first sub-block. */
+        err = getSDOlineOnUse( d, nodeId, whoami, &line );
+        if (!err)
+          err = d->transfers[line].state != SDO_BLOCK_UPLOAD_INIT;
+        if (err) {
+          MSG_ERR(0x1AB8, "SDO error : Received block upload start for unstarted trans. ", nodeId);
+          failedSDO(d, nodeId, whoami, 0, 0, SDOABT_LOCAL_CTRL_ERROR);
+          return 0xFF;
+        }
+        RestartSDO_TIMER(line)
+        d->transfers[line].state = SDO_BLOCK_UPLOAD_IN_PROGRESS;
+        d->transfers[line].blockStart = 0;
+        d->transfers[line].seqno = 0;
+        if (sendSDOblockSegments(d, line)) {
+          failedSDO(d, nodeId, whoami, d->transfers[line].index, d->transfers[line].subIndex,
+                    SDOABT_GENERAL_ERROR);
+          return 0xFF;
+        }
+        break;
+
+      case 2:
+        /* Sub-block acknowledge. Repeating from the first segment lost, or going on. */
+        err = getSDOlineOnUse( d, nodeId, whoami, &line );
+        if (!err)
+          err = d->transfers[line].state != SDO_BLOCK_UPLOAD_IN_PROGRESS;
+        if (err) {
+          MSG_ERR(0x1AB9, "SDO error : Received block upload acknowledge for unstarted trans. ", nodeId);
+          failedSDO(d, nodeId, whoami, 0, 0, SDOABT_LOCAL_CTRL_ERROR);
+          return 0xFF;
+        }
+        RestartSDO_TIMER(line)
+        index = d->transfers[line].index;
+        subIndex = d->transfers[line].subIndex;
+        if (m->data[1] > d->transfers[line].seqno) {
+          MSG_ERR(0x1ABA, "SDO error : Invalid block upload ackseq : ", m->data[1]);
+          failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_INVALID_SEQUENCE);
+          return 0xFF;
+        }
+        if (m->data[2] < 1 || m->data[2] > 127) {
+          MSG_ERR(0x1ABB, "SDO error : Invalid block size : ", m->data[2]);
+          failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_INVALID_BLOCK_SIZE);
+          return 0xFF;
+        }
+        d->transfers[line].blksize = m->data[2];
+        d->transfers[line].offset = d->transfers[line].blockStart + 7 * (UNS32)m->data[1];
+        if (d->transfers[line].offset >= d->transfers[line].count) {
+          /* Everything acknowledged. End block upload. (scs = 6, ss = 1) */
+          d->transfers[line].offset = d->transfers[line].count;
+          nbBytes = d->transfers[line].count ? (d->transfers[line].count - 1) % 7 + 1 : 0;
+          sdo.nodeId = nodeId;
+          sdo.body.data[0] = (UNS8)((6 << 5) | ((7 - nbBytes) << 2) | 1);
+          sdo.body.data[1] = d->transfers[line].crc & 0xFF;
+          sdo.body.data[2] = (d->transfers[line].crc >> 8) & 0xFF;
+          for (i = 3 ; i < 8 ; i++)
+            sdo.body.data[i] = 0;
+          d->transfers[line].state = SDO_BLOCK_UPLOAD_END;
+          MSG_WAR(0x3AB8, "SDO. Sending block upload end defined at index 0x1200 + ", nodeId);
+          sendSDO(d, whoami, sdo);
+        }
+        else {
+          d->transfers[line].blockStart = d->transfers[line].offset;
+          d->transfers[line].seqno = 0;
+          if (sendSDOblockSegments(d, line)) {
+            failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_GENERAL_ERROR);
+            return 0xFF;
+          }
+        }
+        break;
+
+      default:
+        /* End block upload response. Release the line. */
+        err = getSDOlineOnUse( d, nodeId, whoami, &line );
+        if (!err)
+          err = d->transfers[line].state != SDO_BLOCK_UPLOAD_END;
+        if (err) {
+          MSG_ERR(0x1ABC, "SDO error : Received block upload end for unstarted trans. ", nodeId);
+          failedSDO(d, nodeId, whoami, 0, 0, SDOABT_LOCAL_CTRL_ERROR);
+          return 0xFF;
+        }
+        resetSDOline(d, line);
+        MSG_WAR(0x3AB9, "SDO. End of block upload defined at index 0x1200 + ", nodeId);
+        break;
+      }
+    }
+    /* Legacy multi subindex upload. (request 0xA0) */
     /* Receive of an initiate upload.*/
-    if (whoami == SDO_SERVER) 
+    else if (whoami == SDO_SERVER) 
     {
       index = getSDOindex(m->data[1],m->data[2]);
       subIndex = getSDOsubIndex(m->data[3]);
@@ -1455,6 +1934,106 @@ UNS8 processSDO (CO_Data* d, Message *m)
     } /* End if CLIENT */
     break;
 
+  case 6:
+    /* Block download. (ccs = 6) */
+    if (whoami != SDO_SERVER) {
+      MSG_ERR(0x1ABD, "SDO error : Block transfer response while not requested from nodeId", nodeId);
+      failedSDO(d, nodeId, whoami, 0, 0, SDOABT_CS_NOT_VALID);
+      return 0xFF;
+    }
+    if (! getSDOs(m->data[0])) {
+      /* Initiate block download. */
+      index = getSDOindex(m->data[1],m->data[2]);
+      subIndex = getSDOsubIndex(m->data[3]);
+      MSG_WAR(0x3ABA, "Received SDO Initiate block download. Writing at index : ", index);
+      MSG_WAR(0x3ABA, "Writing at subIndex : ", subIndex);
+      err = getSDOlineOnUse( d, nodeId, whoami, &line );
+      if (! err) {
+        MSG_ERR(0x1ABE, "SDO error : Transmission yet started.", 0);
+        failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_LOCAL_CTRL_ERROR);
+        return 0xFF;
+      }
+      err = getSDOfreeLine( d, whoami, &line );
+      if (err) {
+        MSG_ERR(0x1ABF, "SDO error : No line free, too many SDO in progress. Aborted.", 0);
+        failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_LOCAL_CTRL_ERROR);
+        return 0xFF;
+      }
+      initSDOline(d, line, nodeId, index, subIndex, SDO_BLOCK_DOWNLOAD_IN_PROGRESS);
+      errorCode = openSDOstream(d, line, 1);
+      if (errorCode) {
+        failedSDO(d, nodeId, whoami, index, subIndex, errorCode);
+        return 0xFF;
+      }
+      if ((m->data[0] >> 1) & 1) {
+        /* Size indicated */
+        nbBytes = m->data[4] + ((UNS32)(m->data[5])<<8) + ((UNS32)(m->data[6])<<16) + ((UNS32)(m->data[7])<<24);
+        err = setSDOlineRestBytes(d, line, nbBytes);
+        if (err) {
+          failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_OUT_OF_MEMORY);
+          return 0xFF;
+        }
+      }
+      d->transfers[line].blksize = SDO_BLOCK_SIZE;
+      d->transfers[line].crcOn = getSDOcc(m->data[0]);
+      /* Initiate block download response. (scs = 5, sc = 1, ss = 0) */
+      sdo.nodeId = nodeId;
+      sdo.body.data[0] = (5 << 5) | (1 << 2);
+      sdo.body.data[1] = index & 0xFF;        /* LSB */
+      sdo.body.data[2] = (index >> 8) & 0xFF; /* MSB */
+      sdo.body.data[3] = subIndex;
+      sdo.body.data[4] = SDO_BLOCK_SIZE;
+      for (i = 5 ; i < 8 ; i++)
+        sdo.body.data[i] = 0;
+      MSG_WAR(0x3ABB, "SDO. Sending block download initiate response defined at index 0x1200 + ", nodeId);
+      sendSDO(d, whoami, sdo);
+    }
+    else {
+      /* End block download. Removing the padding of the last segment, checking the CRC. */
+      err = getSDOlineOnUse( d, nodeId, whoami, &line );
+      if (!err)
+        err = d->transfers[line].state != SDO_BLOCK_DOWNLOAD_END;
+      if (err) {
+        MSG_ERR(0x1AC0, "SDO error : Received block download end for unstarted trans. ", nodeId);
+        failedSDO(d, nodeId, whoami, 0, 0, SDOABT_LOCAL_CTRL_ERROR);
+        return 0xFF;
+      }
+      index = d->transfers[line].index;
+      subIndex = d->transfers[line].subIndex;
+      if (storeSDOblockSegment(d, line, 7 - getSDOblockN(m->data[0]))) {
+        failedSDO(d, nodeId, whoami, index, subIndex, d->transfers[line].abortCode);
+        return 0xFF;
+      }
+      nbBytes = d->transfers[line].offset;
+      if (d->transfers[line].count && d->transfers[line].count != nbBytes) {
+        MSG_ERR(0x1AC1, "SDO error : Block download size differs from the one indicated : ", nbBytes);
+        failedSDO(d, nodeId, whoami, index, subIndex, OD_LENGTH_DATA_INVALID);
+        return 0xFF;
+      }
+      if (d->transfers[line].crcOn &&
+          d->transfers[line].crc != (m->data[1] | ((UNS16)m->data[2] << 8))) {
+        MSG_ERR(0x1AC2, "SDO error : Block download CRC error. from nodeId", nodeId);
+        failedSDO(d, nodeId, whoami, index, subIndex, SDOABT_CRC_ERROR);
+        return 0xFF;
+      }
+      d->transfers[line].count = nbBytes;
+      errorCode = SDOlineToObjdict(d, line);
+      if (errorCode) {
+        MSG_ERR(0x1AC3, "SDO error : Unable to copy the data in the object dictionary", 0);
+        failedSDO(d, nodeId, whoami, index, subIndex, errorCode);
+        return 0xFF;
+      }
+      /* End block download response. (scs = 5, ss = 1) */
+      sdo.nodeId = nodeId;
+      sdo.body.data[0] = (5 << 5) | 1;
+      for (i = 1 ; i < 8 ; i++)
+        sdo.body.data[i] = 0;
+      sendSDO(d, whoami, sdo);
+      resetSDOline(d, line);
+      MSG_WAR(0x3ABC, "SDO. End of block download defined at index 0x1200 + ", nodeId);
+    }
+    break;
+
   default:
     /* Error : Unknown cs */
     MSG_ERR(0x1AB2, "SDO. Received unknown command specifier : ", getSDOcs(m->data[0]));
@@ -1553,6 +2132,10 @@ INLINE UNS8 _writeNetworkDict (CO_Data* d, UNS8 nodeId, UNS16 index,
   }
   MSG_WAR(0x3AD0,"        SDO client defined at index  : ", 0x1280 + i);
   initSDOline(d, line, nodeId, index, subIndex, SDO_DOWNLOAD_IN_PROGRESS);
+  if (getSDObuffer(d, line)) {
+    resetSDOline(d, line);
+    return 0xFF;
+  }
   d->transfers[line].count = count;
   d->transfers[line].dataType = dataType;
 
@@ -225,7 +225,7 @@ UNS8 setState(CO_Data* d, e_nodeState newState)
 			case Waiting:
 			
 			{
-				s_state_communication newCommunicationState = {0, 1, 1, 1, 1, 1, 0};
+				s_state_communication newCommunicationState = {0, 1, 1, 1, 1, 1, 1}; /* LSS allowed */
 				d->nodeState = Waiting;
 				switchCommunicationState(d, &newCommunicationState);
 				(*d->waiting)(d);
@@ -234,7 +234,7 @@ UNS8 setState(CO_Data* d, e_nodeState newState)
 						
 			case Stopped:
 			{
-				s_state_communication newCommunicationState = {0, 1, 1, 1, 1, 1, 0};
+				s_state_communication newCommunicationState = {0, 1, 1, 1, 1, 1, 1}; /* LSS allowed */
 				d->nodeState = Stopped;
 				switchCommunicationState(d, &newCommunicationState);
 				(*d->stopped)(d);
@@ -339,7 +339,8 @@ void setNodeId(CO_Data* d, UNS8 nodeId)
 
   /* 
    	Initialize the server(s) SDO parameters
-  	Remember that only one SDO server is allowed, defined at index 0x1200	
+  	Only the default server at index 0x1200 follows the node id, the next
+  	servers (0x1201...) get their COB-IDs from the client that uses them
  		
   	
   */
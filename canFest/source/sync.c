@@ -163,6 +163,8 @@ UNS8 processSYNC(CO_Data* d, Message* m)
 {
 
   UNS8 res;
+  TIMEVAL start;
+  UNS32 elapsed;
   
   if(m) //if there is a non-NULL message, let the App use the message
     processSYNCMessageForApp(m);
@@ -175,7 +177,12 @@ UNS8 processSYNC(CO_Data* d, Message* m)
   if(! d->CurrentCommunicationState.csPDO) 
     return 0;
 
+  start = TimerGetTime();
   res = _sendPDOevent(d, 1 /*isSyncEvent*/ );
+  elapsed = TIMEVAL_TO_US(TimerGetTime() - start);
+  SyncStat_TpdoTime = elapsed;
+  if ( elapsed > SyncStat_MaxTpdoTime )
+    SyncStat_MaxTpdoTime = elapsed;
   
   /*Call user app callback*/
   (*d->post_TPDO)(d);
@@ -31,16 +31,121 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <applicfg.h>
 #include "timer.h"
-#include "objdict.h"
+#include "ObjDict.h"
 
 
 /*  ---------  The timer table --------- */
-s_timer_entry timers[MAX_NB_TIMER] = {{TIMER_FREE, NULL, NULL, 0, 0, 0},};
+s_timer_entry timers[MAX_NB_TIMER] = {{TIMER_FREE, NULL, NULL, 0, 0, 0, 0, 0},};
 
-TIMEVAL total_sleep_time = TIMEVAL_MAX;
-TIMER_HANDLE last_timer_raw = -1;
+TIMEVAL total_sleep_time = TIMEVAL_MAX;	/* alarm programmed, in ticks after the timer reference */
+TIMER_HANDLE last_timer_raw = -1;	/* highest row ever used */
 
-#define min_val(a,b) ((a<b)?a:b)
+/* Armed rows ordered by deadline: a binary min-heap of handles, soonest at heap[0] */
+static TIMER_HANDLE heap[MAX_NB_TIMER];
+static TIMER_HANDLE heapSize = 0;
+/* Rows freed below last_timer_raw, reused before a new row is taken */
+static TIMER_HANDLE freeRows[MAX_NB_TIMER];
+static TIMER_HANDLE freeCount = 0;
+/* Absolute time (ticks) of the timer reference, i.e. of the last alarm */
+static TIMEVAL timerBase = 0;
+static UNS8 dispatching = 0;
+/* Expired rows whose callback waits for the main loop, one bit per row */
+#define PENDING_WORDS ((MAX_NB_TIMER + 31) / 32)
+static volatile UNS32 pendingRows[PENDING_WORDS];
+/* Callbacks that still run in the timer isr, see SetAlarmIsrCallback */
+static TimerCallback_t isrCallbacks[TIMER_MAX_ISR_CALLBACKS];
+static UNS8 isrCallbackCount = 0;
+
+/* a is later than b, valid while deadlines are less than half the TIMEVAL range apart */
+#define timeAfter(a,b) ((INTEGER32)((a) - (b)) > 0)
+
+/**
+ * @brief Moves heap entry pos up or down until the heap is ordered again
+ */
+static void heapFix(TIMER_HANDLE pos)
+{
+	TIMER_HANDLE h = heap[pos];
+	TIMER_HANDLE parent, child;
+
+	/* up */
+	while (pos > 0)
+	{
+		parent = (pos - 1) / 2;
+		if (!timeAfter(timers[heap[parent]].val, timers[h].val))
+			break;
+		heap[pos] = heap[parent];
+		timers[heap[pos]].heapPos = pos;
+		pos = parent;
+	}
+	/* down */
+	for (;;)
+	{
+		child = 2 * pos + 1;
+		if (child >= heapSize)
+			break;
+		if (child + 1 < heapSize && timeAfter(timers[heap[child]].val, timers[heap[child + 1]].val))
+			child++;
+		if (!timeAfter(timers[h].val, timers[heap[child]].val))
+			break;
+		heap[pos] = heap[child];
+		timers[heap[pos]].heapPos = pos;
+		pos = child;
+	}
+	heap[pos] = h;
+	timers[h].heapPos = pos;
+}
+
+/**
+ * @brief Removes an armed row from the heap
+ */
+static void heapRemove(TIMER_HANDLE handle)
+{
+	TIMER_HANDLE pos = timers[handle].heapPos;
+
+	heapSize--;
+	if (pos != heapSize)
+	{
+		heap[pos] = heap[heapSize];
+		timers[heap[pos]].heapPos = pos;
+		heapFix(pos);
+	}
+}
+
+/**
+ * @brief Programs the hardware alarm for the soonest deadline, or for TIMEVAL_MAX
+ *  (a harmless wake-up) when nothing is armed.  The compare point is kept ahead of the
+ *  running timer so it cannot be missed.
+ */
+static void timerReprogram(void)
+{
+	TIMEVAL elapsed = getElapsedTime();
+	TIMEVAL next = TIMEVAL_MAX;
+
+	if (heapSize)
+	{
+		TIMEVAL due = timers[heap[0]].val - timerBase;
+
+		if ((INTEGER32)(due - elapsed) < TIMER_MIN_ALARM)
+			due = elapsed + TIMER_MIN_ALARM;	/* already due, fire as soon as possible */
+		if (due < next)
+			next = due;
+	}
+	total_sleep_time = next;
+	setTimer(next);
+}
+
+/**
+ * @brief True when callback is whitelisted to run in the timer isr
+ */
+static UNS8 isIsrCallback(TimerCallback_t callback)
+{
+	UNS8 i;
+
+	for (i = 0; i < isrCallbackCount; i++)
+		if (isrCallbacks[i] == callback)
+			return 1;
+	return 0;
+}
 
 /**
  * @ingroup timer
@@ -56,136 +161,238 @@ TIMER_HANDLE SetAlarm(CO_Data* d, UNS32 id, TimerCallback_t callback, TIMEVAL va
 {
 	TIMER_HANDLE row_number;
 	s_timer_entry *row;
-        
- 
-	/* in order to decide new timer setting we have to run over all timer rows */
-	for(row_number=0, row=timers; row_number <= last_timer_raw + 1 && row_number < MAX_NB_TIMER; row_number++, row++)
+	TIMER_LOCK_T sreg;
+
+	if (!callback)
+		return TIMER_NONE;
+
+	TIMER_LOCK(sreg);
+	if (freeCount)
+		row_number = freeRows[--freeCount];
+	else if (last_timer_raw + 1 < MAX_NB_TIMER)
+		row_number = ++last_timer_raw;
+	else
 	{
-                                
-        if (callback && 	/* if something to store */
-		   row->state == TIMER_FREE) /* and empty row */
-		{	/* just store */
-			TIMEVAL real_timer_value;
-			TIMEVAL elapsed_time;
+		TIMER_UNLOCK(sreg);
+		return TIMER_NONE;
+	}
 
-			if (row_number == last_timer_raw + 1) last_timer_raw++;
+	row = &timers[row_number];
+	row->callback = callback;
+	row->d = d;
+	row->id = id;
+	row->val = timerBase + getElapsedTime() + value;	/* absolute deadline */
+	row->interval = period;
+	row->state = TIMER_ARMED;
 
-			elapsed_time = getElapsedTime();
-			/* set next wakeup alarm if new entry is sooner than others, or if it is alone */
-			real_timer_value = value;
-			real_timer_value = min_val(real_timer_value, TIMEVAL_MAX);
+	row->heapPos = heapSize;
+	heap[heapSize++] = row_number;
+	heapFix(row->heapPos);
 
-			if (total_sleep_time > elapsed_time && total_sleep_time - elapsed_time > real_timer_value)
-			{
-				total_sleep_time = elapsed_time + real_timer_value;
-				setTimer(real_timer_value);
-			}
-			row->callback = callback;
-			row->d = d;
-			row->id = id;
-			row->val = value + elapsed_time;
-			row->interval = period;
-			row->state = TIMER_ARMED;
-                        return row_number;
-		}
-	}
-	return TIMER_NONE;
+	/* a new soonest deadline moves the alarm, TimeDispatch reprograms on its way out */
+	if (heap[0] == row_number && !dispatching)
+		timerReprogram();
+	TIMER_UNLOCK(sreg);
+	return row_number;
 }
 
 /**
  * @ingroup timer
- * @brief Delete an alarm before expiring.
+ * @brief Delete an alarm before expiring.  When it was the soonest the hardware alarm
+ *  is moved to the next deadline.
  * @param handle A timer handle
- * @return The timer handle
+ * @return TIMER_NONE
  */
 TIMER_HANDLE DelAlarm(TIMER_HANDLE handle)
 {
-	/* Quick and dirty. system timer will continue to be trigged, but no action will be preformed. */
-        MSG_WAR(0x3320, "DelAlarm. handle = ", handle);
-	if(handle != TIMER_NONE)
+	TIMER_LOCK_T sreg;
+	UNS8 wasFirst;
+
+	MSG_WAR(0x3320, "DelAlarm. handle = ", handle);
+	if (handle < 0 || handle > last_timer_raw)
+		return TIMER_NONE;
+
+	TIMER_LOCK(sreg);
+	if (timers[handle].state == TIMER_FREE)
 	{
-		if(handle == last_timer_raw)
-			last_timer_raw--;
-		timers[handle].state = TIMER_FREE;
+		TIMER_UNLOCK(sreg);
+		return TIMER_NONE;
 	}
+	if (timers[handle].state & TIMER_ARMED)
+	{
+		wasFirst = (timers[handle].heapPos == 0);
+		heapRemove(handle);
+		if (wasFirst && !dispatching)
+			timerReprogram();
+	}
+	timers[handle].state = TIMER_FREE;	/* a one-shot pending or in its callback is freed here too */
+	freeRows[freeCount++] = handle;
+	TIMER_UNLOCK(sreg);
 	return TIMER_NONE;
 }
 
+/**
+ * @ingroup timer
+ * @brief Lets callback run straight from the timer isr instead of the main loop
+ * @details Only for short, latency-critical callbacks: everything else is deferred
+ *  to TimerDispatchPending so the isr stays short.
+ * @param callback A callback function
+ * @return 1 when registered, 0 when the whitelist is full
+ */
+UNS8 SetAlarmIsrCallback(TimerCallback_t callback)
+{
+	if (isIsrCallback(callback))
+		return 1;
+	if (isrCallbackCount >= TIMER_MAX_ISR_CALLBACKS)
+		return 0;
+	isrCallbacks[isrCallbackCount++] = callback;
+	return 1;
+}
 
-int tdcount=0;
 /**
  * @ingroup timer
  * @brief  TimeDispatch is called on each timer expiration ----
+ * @details The driver has moved its reference to the programmed alarm, so the base 
+ *  advances by total_sleep_time and getElapsedTime() is the overrun.  Every row whose
+ *  deadline has passed is taken off the heap (periodic rows go back with their next 
+ *  deadline).  Whitelisted callbacks run here; the others are only marked pending
+ *  for TimerDispatchPending.
  */
 void TimeDispatch(void)
 {
-	TIMER_HANDLE i;
-	TIMEVAL next_wakeup = TIMEVAL_MAX; /* used to compute when should normaly occur next wakeup */
-	//TIMEVAL next_wakeup = 0x8000; /* used to compute when should normaly occur next wakeup */
-	/* First run : change timer state depending on time */
-	/* Get time since timer signal */
-        
-        UNS32 overrun = (UNS32)getElapsedTime();
-
-	TIMEVAL real_total_sleep_time = total_sleep_time + overrun;
-        
-         
+	TIMER_HANDLE h;
 	s_timer_entry *row;
-        
-	for(i=0, row = timers; i <= last_timer_raw; i++, row++)
+	TIMEVAL now, late;
+
+	timerBase += total_sleep_time;
+	dispatching = 1;
+
+	while (heapSize)
 	{
+		now = timerBase + getElapsedTime();
+		h = heap[0];
+		row = &timers[h];
+		if (timeAfter(row->val, now))
+			break;
 
-                
-		if (row->state & TIMER_ARMED) /* if row is active */
+		row->due = row->val;
+		if (row->interval)	/* periodic, next deadline with overrun correction */
 		{
-                    
-			if (row->val <= real_total_sleep_time) /* to be trigged */
-			{                                
-                         
-				if (!row->interval) /* if simply outdated */
-				{
-					row->state = TIMER_TRIG; /* ask for trig */
-				}
-				else /* or period have expired */
-				{
-					/* set val as interval, with overrun correction */
-                                  /* modulo for 64 bit not available on all platforms     */
-					row->val = row->interval - (overrun % (UNS32)row->interval); //JML
-					row->state = TIMER_TRIG_PERIOD; /* ask for trig, periodic */
-					/* Check if this new timer value is the soonest */
-					if(row->val < next_wakeup)
-						next_wakeup = row->val;
-				}
-			}
-			else
-			{
-				/* Each armed timer value in decremented. */
-				row->val -= real_total_sleep_time;
+			late = now - row->val;
+			row->val = now + row->interval - (late % row->interval);
+			heapFix(0);
+		}
+		else			/* one-shot, freed after the callback unless deleted by it */
+		{
+			heapRemove(h);
+			row->state = TIMER_TRIG;
+		}
 
-				/* Check if this new timer value is the soonest */
-				if(row->val < next_wakeup)
-					next_wakeup = row->val;
-			}
+		if (!isIsrCallback(row->callback))
+		{
+			/* a periodic row still pending from its last period is not queued twice */
+			row->state |= TIMER_PENDING;
+			pendingRows[h >> 5] |= 1UL << (h & 31);
+			continue;
+		}
+
+		(*row->callback)(row->d, row->id); /* trig ! */
+
+		if (row->state == TIMER_TRIG)
+		{
+			row->state = TIMER_FREE;
+			freeRows[freeCount++] = h;
 		}
 	}
 
-	/* Remember how much time we should sleep. */
-	total_sleep_time = next_wakeup;
-             
-	/* Set timer to soonest occurence */
-	setTimer(next_wakeup);
+	dispatching = 0;
+	timerReprogram();
+}
 
-	/* Then trig them or not. */
-	for(i=0, row = timers; i<=last_timer_raw; i++, row++)
+/**
+ * @ingroup timer
+ * @brief Runs the callbacks of the alarms that expired since the last call.  Called
+ *  from the main loop; callbacks may arm and delete alarms.
+ * @details The lag from each deadline to its callback is published in 0x2016.
+ */
+void TimerDispatchPending(void)
+{
+	TIMER_HANDLE h;
+	s_timer_entry *row;
+	TimerCallback_t callback;
+	CO_Data* d;
+	UNS32 id, lag;
+	TIMER_LOCK_T sreg;
+	UNS8 w;
+
+	for (w = 0; w < PENDING_WORDS; w++)
 	{
-		if (row->state & TIMER_TRIG)
-		{                       
-			row->state &= ~TIMER_TRIG; /* reset trig state (will be free if not periodic) */
-			if(row->callback)
-                        {
- 				(*row->callback)(row->d, row->id); /* trig ! */
-	                  }
+		while (pendingRows[w])
+		{
+			TIMER_LOCK(sreg);
+			for (h = 0; !(pendingRows[w] & (1UL << h)); h++)
+				;
+			pendingRows[w] &= ~(1UL << h);
+			h += w << 5;
+			row = &timers[h];
+			if (!(row->state & TIMER_PENDING))	/* deleted while pending */
+			{
+				TIMER_UNLOCK(sreg);
+				continue;
+			}
+			row->state &= ~TIMER_PENDING;
+			callback = row->callback;
+			d = row->d;
+			id = row->id;
+			lag = timerBase + getElapsedTime() - row->due;
+			TIMER_UNLOCK(sreg);
+
+			lag = TIMEVAL_TO_US(lag);
+			TimerStat_DispatchLag = lag;
+			if (lag > TimerStat_MaxDispatchLag)
+				TimerStat_MaxDispatchLag = lag;
+			TimerStat_DeferredCount++;
+
+			(*callback)(d, id); /* trig ! */
+
+			TIMER_LOCK(sreg);
+			if (row->state == TIMER_TRIG)
+			{
+				row->state = TIMER_FREE;
+				freeRows[freeCount++] = h;
+			}
+			TIMER_UNLOCK(sreg);
 		}
 	}
-        
+}
+
+/**
+ * @ingroup timer
+ * @brief Current time on the alarm timebase, for measuring durations
+ * @return TIMEVAL ticks, wrapping
+ */
+TIMEVAL TimerGetTime(void)
+{
+	TIMEVAL now;
+	TIMER_LOCK_T sreg;
+
+	TIMER_LOCK(sreg);
+	now = timerBase + getElapsedTime();
+	TIMER_UNLOCK(sreg);
+	return now;
+}
+
+/**
+ * @ingroup timer
+ * @brief True while expired alarms wait for TimerDispatchPending, the main loop must
+ *  not sleep on them
+ */
+UNS8 TimerPending(void)
+{
+	UNS8 w;
+
+	for (w = 0; w < PENDING_WORDS; w++)
+		if (pendingRows[w])
+			return 1;
+	return 0;
 }